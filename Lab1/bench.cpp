@@ -0,0 +1,991 @@
+// Benchmarks for the Lab1 automata. Configure with -DCMAKE_BUILD_TYPE=Release,
+// build the `bench` target and run ./bench from the build directory.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <numeric>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "grammar.h"
+#include "compiledDFA.h"
+#include "packedDFA.h"
+#include "lazyDFA.h"
+#include "staticDFA.h"
+#include "basicDFA.h"
+#include "wordGenerator.h"
+#include "uniformSampler.h"
+#include "shortlexEnumerator.h"
+#include "approximateMatcher.h"
+#include "benchVariantMatches.h"
+
+// live heap bytes, tracked by the replacement operator new/delete below;
+// atomic because ThreadPool workers and the grammar cache threads allocate too
+static std::atomic<std::size_t> g_liveBytes {0};
+
+void* operator new(std::size_t size)
+{
+    auto* p = static_cast<std::size_t*>(std::malloc(size + sizeof(std::max_align_t)));
+    if (!p)
+        throw std::bad_alloc{};
+    *p = size;
+    g_liveBytes.fetch_add(size, std::memory_order_relaxed);
+    return reinterpret_cast<char*>(p) + sizeof(std::max_align_t);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+    auto* p = reinterpret_cast<std::size_t*>(static_cast<char*>(ptr) - sizeof(std::max_align_t));
+    g_liveBytes.fetch_sub(*p, std::memory_order_relaxed);
+    std::free(p);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    Grammar variantGrammar()
+    {
+        std::set<Symbol> nonterminals{"S", "P", "Q"};
+        std::set<Symbol> terminals{"a", "b", "c", "d", "e", "f"};
+        std::vector<Production> productions = {
+            {{"S"}, {"a", "P"}}, {{"S"}, {"b", "Q"}}, {{"P"}, {"b", "P"}},
+            {{"P"}, {"c", "P"}}, {{"P"}, {"d", "Q"}}, {{"P"}, {"e"}},
+            {{"Q"}, {"e", "Q"}}, {{"Q"}, {"f", "Q"}}, {{"Q"}, {"a"}}
+        };
+        return Grammar{terminals, nonterminals, "S", productions};
+    }
+
+    // Two identical copies of an n-state counter over {a, b} joined by epsilon moves.
+    // Every subset is {i, i'}, so toDFA() yields n states, of which only `period` are distinct.
+    FiniteAutomaton syntheticNFA(int n, int period)
+    {
+        std::set<Symbol> states{"S"};
+        std::set<Symbol> finals{};
+        std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> transitions{};
+        for (const std::string copy : {"L", "R"})
+        {
+            transitions[{"S", ""}].insert(copy + "0");
+            for (int i = 0; i < n; ++i)
+            {
+                Symbol from = copy + std::to_string(i);
+                Symbol to = copy + std::to_string((i + 1) % n);
+                states.insert(from);
+                transitions[{from, "a"}].insert(to);
+                transitions[{from, "b"}].insert(to);
+                if (i % period == 0)
+                    finals.insert(from);
+            }
+        }
+        return FiniteAutomaton{states, {"a", "b"}, transitions, "S", finals};
+    }
+
+    // Σ* (a A | b B) with A and B two bisimilar copies of a Σ^k chain: unreduced,
+    // every subset records which copy each of the last k+1 letters entered
+    // (2^(k+1) subsets); merged, the language is just Σ^{k+1} Σ*
+    FiniteAutomaton redundantNFA(int k)
+    {
+        std::ostringstream text {};
+        text << "%initial S\n%final A" << k << " B" << k << "\nS a S\nS b S\nS a A0\nS b B0\n";
+        for (int i = 0; i < k; ++i)
+            for (const char* copy : {"A", "B"})
+                text << copy << i << " a " << copy << i + 1 << "\n" << copy << i << " b " << copy << i + 1 << "\n";
+        return FiniteAutomaton::fromText(text.str());
+    }
+
+    // Σ* a a^k: no two states merge, so reduce() is pure overhead before subset construction
+    FiniteAutomaton chainNFA(int k)
+    {
+        std::ostringstream text {};
+        text << "%initial S\n%final Q" << k << "\nS a S\nS b S\nS a Q0\n";
+        for (int i = 0; i < k; ++i)
+            text << "Q" << i << " a Q" << i + 1 << "\n";
+        return FiniteAutomaton::fromText(text.str());
+    }
+
+    // Σ* w1 | Σ* w2 | ... for `count` random keywords: 1 + count * length NFA states
+    FiniteAutomaton keywordNFA(const std::string& letters, int count, int length)
+    {
+        std::mt19937 mt{777};
+        std::uniform_int_distribution<size_t> letter(0, letters.size() - 1);
+        std::set<Symbol> states{"S"};
+        std::set<Symbol> alphabet{};
+        std::set<Symbol> finals{};
+        std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> transitions{};
+        for (char c : letters)
+        {
+            alphabet.insert(Symbol(1, c));
+            transitions[{"S", Symbol(1, c)}].insert("S");
+        }
+        for (int w = 0; w < count; ++w)
+        {
+            Symbol from = "S";
+            for (int i = 0; i < length; ++i)
+            {
+                Symbol to = "K" + std::to_string(w) + "_" + std::to_string(i);
+                states.insert(to);
+                transitions[{from, Symbol(1, letters[letter(mt)])}].insert(to);
+                from = to;
+            }
+            finals.insert(from);
+        }
+        return FiniteAutomaton{states, alphabet, transitions, "S", finals};
+    }
+
+    // n-state DFA over `letters` with uniformly random targets, in text form so
+    // state indices follow q0, q1, ...; about one state in ten is final
+    FiniteAutomaton randomDFA(int n, const std::string& letters)
+    {
+        std::mt19937 mt{4242};
+        std::uniform_int_distribution<int> target(0, n - 1);
+        std::string text = "%initial q0\n%final";
+        for (int q = 0; q < n; q += 10)
+            text += " q" + std::to_string(q);
+        text += "\n";
+        for (int q = 0; q < n; ++q)
+            for (char c : letters)
+                text += "q" + std::to_string(q) + " " + c + " q" + std::to_string(target(mt)) + "\n";
+        return FiniteAutomaton::fromText(text);
+    }
+
+    // `count` draws from `vocabulary` with Zipf(1) frequencies
+    std::vector<std::string_view> zipfSample(const std::vector<std::string>& vocabulary, size_t count, unsigned seed)
+    {
+        std::vector<double> weights(vocabulary.size());
+        for (size_t i = 0; i < weights.size(); ++i)
+            weights[i] = 1.0 / (i + 1);
+        std::mt19937 mt{seed};
+        std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+        std::vector<std::string_view> sample(count);
+        for (auto& w : sample)
+            w = vocabulary[pick(mt)];
+        return sample;
+    }
+
+    // the DFA toDFA() would make of keywordNFA, built directly with Aho-Corasick
+    // goto/failure links: subset construction of an NFA this large needs too much memory
+    FiniteAutomaton keywordDFA(const std::string& letters, int count, int length)
+    {
+        std::mt19937 mt{777};
+        std::uniform_int_distribution<size_t> letter(0, letters.size() - 1);
+        const size_t k = letters.size();
+        std::vector<int> go(k, -1);   // node * k + letter, -1 = missing
+        std::vector<char> final(1, 0);
+        for (int w = 0; w < count; ++w)
+        {
+            int node = 0;
+            for (int i = 0; i < length; ++i)
+            {
+                const size_t slot = node * k + letter(mt);
+                if (go[slot] < 0)
+                {
+                    go[slot] = static_cast<int>(final.size());
+                    final.push_back(0);
+                    go.resize(go.size() + k, -1);
+                }
+                node = go[slot];
+            }
+            final[node] = 1;
+        }
+        std::vector<int> fail(final.size(), 0);
+        std::vector<int> queue{};
+        for (size_t c = 0; c < k; ++c)
+            if (go[c] < 0)
+                go[c] = 0;
+            else
+                queue.push_back(go[c]);
+        for (size_t head = 0; head < queue.size(); ++head)
+        {
+            const int node = queue[head];
+            final[node] |= final[fail[node]];
+            for (size_t c = 0; c < k; ++c)
+            {
+                int& child = go[node * k + c];
+                if (child < 0)
+                    child = go[fail[node] * k + c];
+                else
+                {
+                    fail[child] = go[fail[node] * k + c];
+                    queue.push_back(child);
+                }
+            }
+        }
+        std::string text = "%initial q0\n%final";
+        for (size_t q = 0; q < final.size(); ++q)
+            if (final[q])
+                text += " q" + std::to_string(q);
+        text += "\n";
+        for (size_t q = 0; q < final.size(); ++q)
+            for (size_t c = 0; c < k; ++c)
+                text += "q" + std::to_string(q) + " " + letters[c] + " q" + std::to_string(go[q * k + c]) + "\n";
+        return FiniteAutomaton::fromText(text);
+    }
+
+    // set-associative LRU cache; a stand-in for hardware miss counters, which
+    // are not available everywhere the bench runs. With 4 KiB lines it models a TLB.
+    class CacheModel
+    {
+    public:
+        CacheModel(std::size_t bytes, std::size_t ways, std::size_t lineBytes = 64)
+            : m_ways{ways}, m_sets{bytes / lineBytes / ways}, m_lineBytes{lineBytes}, m_lines(m_sets * ways, ~std::uint64_t{0}) {}
+        void access(std::uint64_t address)
+        {
+            const std::uint64_t line = address / m_lineBytes;
+            std::uint64_t* set = &m_lines[(line % m_sets) * m_ways];
+            std::size_t i = 0;
+            while (i < m_ways && set[i] != line)
+                ++i;
+            if (i == m_ways)
+            {
+                ++m_misses;
+                i = m_ways - 1;
+            }
+            for (; i > 0; --i) // move to front
+                set[i] = set[i - 1];
+            set[0] = line;
+        }
+        std::size_t misses() const { return m_misses; }
+
+    private:
+        std::size_t m_ways, m_sets, m_lineBytes;
+        std::vector<std::uint64_t> m_lines;
+        std::size_t m_misses{0};
+    };
+
+    // right-linear grammar with `nonterminals` * 5 productions; every nonterminal
+    // uses distinct terminals, so its automaton is already deterministic
+    Grammar largeGrammar(int nonterminals)
+    {
+        std::mt19937 mt{99};
+        std::uniform_int_distribution<int> target(0, nonterminals - 1);
+        std::set<Symbol> terminals{};
+        std::set<Symbol> names{};
+        for (char c = 'a'; c <= 'z'; ++c)
+            terminals.insert(Symbol(1, c));
+        std::vector<Production> productions{};
+        for (int i = 0; i < nonterminals; ++i)
+        {
+            Symbol lhs = "N" + std::to_string(i);
+            names.insert(lhs);
+            int offset = i % 20;
+            for (int k = 0; k < 4; ++k)
+                productions.push_back({{lhs}, {Symbol(1, 'a' + offset + k), "N" + std::to_string(target(mt))}});
+            productions.push_back({{lhs}, {Symbol(1, 'a' + offset + 4)}});
+        }
+        return Grammar{terminals, names, "N0", productions};
+    }
+
+    std::vector<std::string> randomWords(const std::string& letters, size_t count, size_t maxLength)
+    {
+        std::mt19937 mt{12345};
+        std::uniform_int_distribution<size_t> length(0, maxLength);
+        std::uniform_int_distribution<size_t> letter(0, letters.size() - 1);
+        std::vector<std::string> words(count);
+        for (auto& w : words)
+        {
+            w.resize(length(mt));
+            for (auto& c : w)
+                c = letters[letter(mt)];
+        }
+        return words;
+    }
+
+    double matchRate(const FiniteAutomaton& fa, const std::vector<std::string>& words, size_t& accepted)
+    {
+        accepted = 0;
+        auto start = Clock::now();
+        for (const auto& w : words)
+            accepted += fa.stringBelongsToLanguage(w);
+        return words.size() / secondsSince(start);
+    }
+
+    void benchMinimize(const std::string& name, const FiniteAutomaton& nfa, const std::vector<std::string>& words)
+    {
+        auto start = Clock::now();
+        FiniteAutomaton dfa = nfa.toDFA();
+        double dfaTime = secondsSince(start);
+        start = Clock::now();
+        FiniteAutomaton minimal = dfa.minimize();
+        double minTime = secondsSince(start);
+
+        size_t acceptedDfa{}, acceptedMin{};
+        double dfaRate = matchRate(dfa, words, acceptedDfa);
+        double minRate = matchRate(minimal, words, acceptedMin);
+
+        std::cout << name << "\n"
+                  << "  states: nfa " << nfa.stateCount() << ", toDFA " << dfa.stateCount()
+                  << ", minimized " << minimal.stateCount() << "\n"
+                  << "  toDFA " << dfaTime * 1e3 << " ms, minimize " << minTime * 1e3 << " ms\n"
+                  << "  match toDFA " << dfaRate / 1e6 << " Mstr/s, minimized " << minRate / 1e6
+                  << " Mstr/s (accepted " << acceptedDfa << " / " << acceptedMin << ")\n";
+    }
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::cout << "== conversions (100k productions) ==\n";
+    {
+        auto start = Clock::now();
+        std::size_t before = g_liveBytes;
+        Grammar g = largeGrammar(20'000);
+        std::cout << "grammar: " << secondsSince(start) * 1e3 << " ms, "
+                  << (g_liveBytes - before) / 1024 << " KiB\n";
+
+        start = Clock::now();
+        before = g_liveBytes;
+        FiniteAutomaton fa = g.toFiniteAutomaton();
+        std::cout << "toFiniteAutomaton: " << secondsSince(start) * 1e3 << " ms, "
+                  << (g_liveBytes - before) / 1024 << " KiB\n";
+
+        start = Clock::now();
+        before = g_liveBytes;
+        Grammar back = fa.toGrammar();
+        std::cout << "toGrammar: " << secondsSince(start) * 1e3 << " ms, "
+                  << (g_liveBytes - before) / 1024 << " KiB\n";
+
+        start = Clock::now();
+        before = g_liveBytes;
+        FiniteAutomaton dfa = fa.toDFA();
+        std::cout << "toDFA: " << secondsSince(start) * 1e3 << " ms, "
+                  << (g_liveBytes - before) / 1024 << " KiB, " << dfa.stateCount() << " states\n";
+        FiniteAutomaton::Stats stats = dfa.stats();
+        std::cout << "compiled table: " << stats.classes << " byte classes, " << stats.tableBytes / 1024
+                  << " KiB (" << (stats.states + 1) * 256 * sizeof(std::uint32_t) / 1024 << " KiB with 256 columns)\n";
+
+        // what a worker process would do instead of rebuilding from the grammar
+        const std::string path {(std::filesystem::temp_directory_path() / "lfa_bench.dfa").string()};
+        dfa.compiledDFA()->save(path);
+        for (bool verify : {true, false})
+        {
+            start = Clock::now();
+            CompiledDFA loaded = CompiledDFA::load(path, verify);
+            std::cout << "load compiled DFA (" << (verify ? "checksum" : "no checksum") << "): "
+                      << secondsSince(start) * 1e3 << " ms, " << loaded.stateCount() - 1 << " states\n";
+        }
+        std::filesystem::remove(path);
+        std::cout << "\n";
+    }
+
+    std::cout << "== minimize ==\n";
+    benchMinimize("Lab1 variant grammar", variantGrammar().toFiniteAutomaton(),
+                  randomWords("abcdef", 1'000'000, 32));
+    benchMinimize("synthetic counter NFA", syntheticNFA(10'010, 7),
+                  randomWords("ab", 1'000'000, 32));
+
+    std::cout << "\n== compile-time and generated matchers (Lab1 variant) ==\n";
+    {
+        static constexpr const char* VARIANT[] = {
+            "S->aP", "S->bQ", "P->bP", "P->cP", "P->dQ", "P->e", "Q->eQ", "Q->fQ", "Q->a"
+        };
+        static constexpr auto fixed = StaticDFA<>::fromGrammar(VARIANT, 'S');
+        auto start = Clock::now();
+        FiniteAutomaton runtime = variantGrammar().toFiniteAutomaton().toDFA(true);
+        std::cout << "runtime construction: " << secondsSince(start) * 1e3 << " ms, compile-time: 0 ms\n";
+
+        // short random words mostly die within a few bytes; long accepted ones
+        // (a[bc]*e) measure the per-byte step
+        auto shortWords = randomWords("abcdef", 2'000'000, 32);
+        auto longWords = randomWords("bc", 200'000, 512);
+        for (auto& w : longWords)
+            w = 'a' + w + 'e';
+        for (const auto* words : {&shortWords, &longWords})
+        {
+            size_t acceptedRuntime{}, acceptedFixed{};
+            start = Clock::now();
+            for (const auto& w : *words)
+                acceptedRuntime += runtime.stringBelongsToLanguage(w);
+            double runtimeRate = words->size() / secondsSince(start);
+            start = Clock::now();
+            for (const auto& w : *words)
+                acceptedFixed += fixed.matches(w);
+            double fixedRate = words->size() / secondsSince(start);
+            size_t acceptedGenerated{};
+            start = Clock::now();
+            for (const auto& w : *words)
+                acceptedGenerated += benchVariantMatches(w);
+            double generatedRate = words->size() / secondsSince(start);
+            std::cout << (words == &shortWords ? "short random words: " : "long accepted words: ")
+                      << "runtime table " << runtimeRate / 1e6 << " Mstr/s, constexpr table " << fixedRate / 1e6
+                      << " Mstr/s, lfagen switch " << generatedRate / 1e6 << " Mstr/s (accepted "
+                      << acceptedRuntime << " / " << acceptedFixed << " / " << acceptedGenerated << ")\n";
+        }
+    }
+
+    std::cout << "\n== self-loop acceleration (a[bc]*e, 64 MiB runs) ==\n";
+    {
+        FiniteAutomaton dfa = variantGrammar().toFiniteAutomaton().toDFA(true);
+        BasicDFA<std::uint32_t, char> stepped {dfa};
+        std::string run(64 << 20, 'b');
+        for (std::size_t i = 0; i < run.size(); i += 7)
+            run[i] = 'c';
+        run.front() = 'a';
+        run.back() = 'e';
+        std::string plain(run.size(), 'b');
+        auto gbps = [&](auto&& match, const std::string& text) {
+            auto start = Clock::now();
+            bool accepted = match(text);
+            double rate = text.size() / secondsSince(start) / 1e9;
+            return std::make_pair(rate, accepted);
+        };
+        auto [acceleratedRate, a1] = gbps([&](const std::string& t) { return dfa.stringBelongsToLanguage(t); }, run);
+        auto [steppedRate, a2] = gbps([&](const std::string& t) { return stepped.matches(std::string_view{t}); }, run);
+        auto [memchrRate, a3] = gbps([](const std::string& t) { return std::memchr(t.data(), 'x', t.size()) != nullptr; }, plain);
+        std::cout << "accelerated " << acceleratedRate << " GB/s, byte stepping " << steppedRate
+                  << " GB/s, memchr " << memchrRate << " GB/s (accepted " << a1 << " / " << a2 << ", found " << a3
+                  << ")\n";
+    }
+
+    std::cout << "\n== profile-guided state reordering (random 200k-state DFA, Zipf words) ==\n";
+    {
+        FiniteAutomaton dfa = randomDFA(200'000, "abcd");
+        auto vocabulary = randomWords("abcd", 50'000, 64);
+        auto corpus = zipfSample(vocabulary, 200'000, 1);
+        auto words = zipfSample(vocabulary, 2'000'000, 2);
+        auto start = Clock::now();
+        FiniteAutomaton hot = dfa.reorderStates(corpus);
+        std::cout << dfa.stats().tableBytes / 1024 << " KiB table; profile + reorder: " << secondsSince(start) * 1e3
+                  << " ms\n";
+        FiniteAutomaton depthFirst = dfa.reorderStates();
+        for (const auto& [name, fa] : {std::pair<const char*, const FiniteAutomaton*>{"discovery order", &dfa},
+                                       {"depth-first", &depthFirst}, {"profile-guided", &hot}})
+        {
+            const CompiledDFA& table = *fa->compiledDFA();
+            CacheModel l1{32 << 10, 8}, l2{1 << 20, 16}, tlb{64 << 12, 4, 4096};
+            std::size_t steps = 0;
+            for (std::string_view w : words)
+            {
+                CompiledDFA::StateId s = table.startState();
+                for (unsigned char c : w)
+                {
+                    const std::uint64_t address = (std::uint64_t{s} + table.classOf(c)) * sizeof(CompiledDFA::StateId);
+                    l1.access(address);
+                    l2.access(address);
+                    tlb.access(address);
+                    s = table.next(s, c);
+                    ++steps;
+                }
+            }
+            size_t accepted = 0;
+            start = Clock::now();
+            for (std::string_view w : words)
+                accepted += fa->stringBelongsToLanguage(w);
+            double rate = words.size() / secondsSince(start);
+            std::cout << name << ": model misses per step L1 " << 100.0 * l1.misses() / steps << "%, L2 "
+                      << 100.0 * l2.misses() / steps << "%, TLB " << 100.0 * tlb.misses() / steps << "%; "
+                      << rate / 1e6 << " Mstr/s (accepted " << accepted << ")\n";
+        }
+    }
+
+    std::cout << "\n== dense vs comb-packed tables ==\n";
+    {
+        auto report = [](const char* name, const FiniteAutomaton& dfa, const std::vector<std::string>& words) {
+            auto start = Clock::now();
+            PackedDFA packed{*dfa.compiledDFA()};
+            double packSeconds = secondsSince(start);
+            const CompiledDFA& dense = *dfa.compiledDFA();
+            size_t acceptedDense = 0, acceptedPacked = 0;
+            start = Clock::now();
+            for (const auto& w : words)
+                acceptedDense += dense.matches(w);
+            double denseRate = words.size() / secondsSince(start);
+            start = Clock::now();
+            for (const auto& w : words)
+                acceptedPacked += packed.matches(w);
+            double packedRate = words.size() / secondsSince(start);
+            FiniteAutomaton chosen = dfa.withTableBudget(8 << 20);
+            std::cout << name << ": " << dense.stateCount() - 1 << " states, " << dense.classCount() << " classes\n"
+                      << "  dense  " << static_cast<double>(dense.tableBytes()) / dense.stateCount() << " B/state, "
+                      << dense.tableBytes() / 1024 << " KiB, " << denseRate / 1e6 << " Mstr/s\n"
+                      << "  packed " << packed.bytesPerState() << " B/state, " << packed.tableBytes() / 1024 << " KiB, "
+                      << packedRate / 1e6 << " Mstr/s, packed in " << packSeconds * 1e3 << " ms ("
+                      << packed.fallbackRows() << " rows fall back to another row)\n"
+                      << "  8 MiB budget picks " << (chosen.stats().packed ? "packed" : "dense")
+                      << " (accepted " << acceptedDense << " / " << acceptedPacked << ")\n";
+        };
+        auto start = Clock::now();
+        FiniteAutomaton keywords = keywordDFA("abcdefghijklmnop", 20'000, 12);
+        std::cout << "keyword DFA built in " << secondsSince(start) * 1e3 << " ms\n";
+        report("keyword DFA (20k keywords over 16 letters)", keywords, randomWords("abcdefghijklmnop", 1'000'000, 64));
+        report("random DFA", randomDFA(200'000, "abcd"), randomWords("abcd", 1'000'000, 64));
+    }
+
+    std::cout << "\n== state id width (32-bit CompiledDFA vs AutoDFA) ==\n";
+    {
+        auto words = randomWords("abcdef", 2'000'000, 32);
+        auto report = [&](const char* name, const FiniteAutomaton& dfa) {
+            AutoDFA<char> narrow {dfa};
+            size_t acceptedWide{}, acceptedNarrow{};
+            auto start = Clock::now();
+            for (const auto& w : words)
+                acceptedWide += dfa.stringBelongsToLanguage(w);
+            double wideRate = words.size() / secondsSince(start);
+            start = Clock::now();
+            for (const auto& w : words)
+                acceptedNarrow += narrow.matches(std::string_view{w});
+            double narrowRate = words.size() / secondsSince(start);
+            std::cout << name << ": " << narrow.stateCount() << " states, table " << dfa.stats().tableBytes
+                      << " B -> " << narrow.tableBytes() << " B (" << narrow.stateBytes() << "-byte ids); "
+                      << wideRate / 1e6 << " vs " << narrowRate / 1e6 << " Mstr/s (accepted " << acceptedWide
+                      << " / " << acceptedNarrow << ")\n";
+        };
+        report("Lab1 variant", variantGrammar().toFiniteAutomaton().toDFA(true));
+        report("keyword DFA", keywordNFA("abcdef", 200, 10).toDFA(true));
+    }
+
+    std::cout << "\n== determinize ==\n";
+    {
+        auto report = [](const std::string& name, const FiniteAutomaton& nfa) {
+            auto start = Clock::now();
+            FiniteAutomaton dfa = nfa.toDFA();
+            const double seconds {secondsSince(start)};
+            start = Clock::now();
+            FiniteAutomaton plain = nfa.toDFA(false, FiniteAutomaton::DEFAULT_STATE_BUDGET, false);
+            std::cout << name << " " << nfa.stateCount() << " states -> " << dfa.stateCount() << " DFA states in "
+                      << seconds * 1e3 << " ms; without reduce() " << plain.stateCount() << " in "
+                      << secondsSince(start) * 1e3 << " ms\n";
+        };
+        for (int count : {50, 200, 500})
+            report("keyword NFA", keywordNFA("abcd", count, 10));
+        for (int k : {1000, 4000})
+            report("chain NFA k=" + std::to_string(k), chainNFA(k));
+    }
+
+    std::cout << "\n== NFA reduction before subset construction ==\n";
+    {
+        auto report = [](const char* name, const FiniteAutomaton& nfa) {
+            auto start = Clock::now();
+            const std::size_t plain {nfa.toDFA(false, FiniteAutomaton::DEFAULT_STATE_BUDGET, false).stateCount()};
+            const double plainSeconds {secondsSince(start)};
+            ReductionReport r {};
+            start = Clock::now();
+            const FiniteAutomaton reduced {nfa.reduce(&r)};
+            const double reduceSeconds {secondsSince(start)};
+            const std::size_t subsets {reduced.toDFA(false, FiniteAutomaton::DEFAULT_STATE_BUDGET, false).stateCount()};
+            const double totalSeconds {secondsSince(start)};
+            std::cout << name << ": " << r.statesBefore << " states, " << r.transitionsBefore << " transitions -> trim "
+                      << r.afterTrim << ", forward " << r.afterForward << ", backward " << r.afterBackward
+                      << ", simulation " << r.afterSimulation << " (" << r.prunedTransitions << " pruned) -> "
+                      << r.statesAfter << " states, " << r.transitionsAfter << " transitions in "
+                      << reduceSeconds * 1e3 << " ms\n  subsets " << plain << " in " << plainSeconds * 1e3
+                      << " ms unreduced vs " << subsets << " in " << totalSeconds * 1e3 << " ms reduced\n";
+        };
+        for (int k : {8, 16})
+            report(("redundant chain k=" + std::to_string(k)).c_str(), redundantNFA(k));
+        report("synthetic counter NFA", syntheticNFA(10'010, 7));
+        report("keyword NFA", keywordNFA("abcd", 200, 10));
+    }
+
+    std::cout << "\n== language equivalence ==\n";
+    {
+        auto report = [](const char* name, const FiniteAutomaton& x, const FiniteAutomaton& y) {
+            std::string counterexample {};
+            auto start = Clock::now();
+            const bool equal {x.equivalentTo(y, &counterexample)};
+            const double checkSeconds {secondsSince(start)};
+            start = Clock::now();
+            const FiniteAutomaton mx {x.toDFA(true)};
+            const FiniteAutomaton my {y.toDFA(true)};
+            const double determinizeSeconds {secondsSince(start)};
+            std::cout << name << ": " << (equal ? "equal" : "differ on \"" + counterexample + "\"") << " in "
+                      << checkSeconds * 1e3 << " ms vs " << determinizeSeconds * 1e3
+                      << " ms to determinize and minimize both (" << mx.stateCount() << ", " << my.stateCount()
+                      << " states)\n";
+        };
+        const FiniteAutomaton keywords {keywordNFA("abcd", 200, 10)};
+        const FiniteAutomaton keywordDFA {keywords.toDFA(true)};
+        report("keyword NFA vs its minimal DFA", keywords, keywordDFA);
+        report("keyword DFA vs itself, unminimized", keywordDFA, keywords.toDFA());
+        report("keyword NFA vs one keyword fewer", keywords, keywordNFA("abcd", 199, 10));
+        report("redundant chain k=16 vs k=15", redundantNFA(16), redundantNFA(15));
+        const FiniteAutomaton counter {syntheticNFA(10'010, 7)};
+        report("synthetic counter NFA vs its reduction", counter, counter.reduce());
+    }
+
+    std::cout << "\n== grammar cache (keyword grammar, 200 keywords) ==\n";
+    {
+        const FiniteAutomaton keywords {keywordNFA("abcd", 200, 10)};
+        const Grammar first {keywords.toGrammar()};
+        auto start = Clock::now();
+        const FiniteAutomaton& matcher {first.toMatcher()};
+        const double buildSeconds {secondsSince(start)};
+        // an equal grammar from another component: hashed and looked up, not rebuilt
+        const Grammar second {keywords.toGrammar()};
+        start = Clock::now();
+        const bool shared {&second.toMatcher() == &matcher};
+        const double hitSeconds {secondsSince(start)};
+        // eight threads sharing one fresh grammar
+        const Grammar third {keywordNFA("abcd", 201, 10).toGrammar()};
+        std::vector<std::thread> workers {};
+        std::vector<const FiniteAutomaton*> built(8, nullptr);
+        start = Clock::now();
+        for (std::size_t i = 0; i < built.size(); ++i)
+            workers.emplace_back([&, i] { built[i] = &third.toMatcher(); });
+        for (auto& w : workers)
+            w.join();
+        const double threadSeconds {secondsSince(start)};
+        std::cout << "first toMatcher " << buildSeconds * 1e3 << " ms (" << matcher.stateCount()
+                  << " states), equal grammar " << hitSeconds * 1e3 << " ms (shared " << shared
+                  << "), 8 threads on a new grammar " << threadSeconds * 1e3 << " ms (one build "
+                  << std::all_of(built.begin(), built.end(), [&](const FiniteAutomaton* m) { return m == built[0]; })
+                  << "), live entries " << GrammarCache::shared().size() << "\n";
+    }
+
+    std::cout << "\n== word generation (Lab1 variant) ==\n";
+    {
+        const Grammar grammar {variantGrammar()};
+        const FiniteAutomaton& fa {grammar.toFiniteAutomaton()};
+        // what generateWord() used to do per word: fresh random_device, seed_seq and mt19937
+        constexpr std::size_t OLD_WORDS {20'000};
+        std::size_t oldBytes {0};
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < OLD_WORDS; ++i)
+        {
+            std::random_device rd {};
+            std::seed_seq seed {rd(), rd(), rd(), rd(), rd(), rd(), rd(), rd()};
+            std::mt19937 mt {seed};
+            std::string word {};
+            std::size_t s {fa.initialIndex()};
+            for (int steps = 0; steps < 20 && !fa.isFinal(s); ++steps)
+            {
+                const Transition* choices {fa.transitionsBegin(s)};
+                const std::size_t count = fa.transitionsEnd(s) - choices;
+                if (count == 0)
+                    break;
+                const Transition& choice {choices[std::uniform_int_distribution<std::size_t>(0, count - 1)(mt)]};
+                word += fa.symbols().name(choice.symbol);
+                s = choice.to;
+            }
+            oldBytes += word.size();
+        }
+        const double oldRate {OLD_WORDS / secondsSince(start)};
+
+        constexpr std::size_t WORDS {10'000'000};
+        WordGenerator generator {grammar.wordGenerator(1)};
+        std::string buffer {};
+        std::vector<std::size_t> ends {};
+        start = Clock::now();
+        generator.generate(WORDS, buffer, ends);
+        const double batchSeconds {secondsSince(start)};
+        std::size_t sinkBytes {0};
+        start = Clock::now();
+        generator.generate(WORDS, [&](std::string_view w) { sinkBytes += w.size(); });
+        const double sinkSeconds {secondsSince(start)};
+        std::cout << "per-call random_device + mt19937: " << oldRate / 1e6 << " Mwords/s (" << oldBytes
+                  << " bytes)\nWordGenerator batch: " << WORDS / batchSeconds / 1e6 << " Mwords/s, "
+                  << buffer.size() / batchSeconds / 1e6 << " MB/s; sink: " << WORDS / sinkSeconds / 1e6
+                  << " Mwords/s (" << sinkBytes << " bytes)\n";
+    }
+
+    std::cout << "\n== weighted generation (one state, Zipf weights) ==\n";
+    for (int degree : {4, 64, 1024})
+    {
+        // S loops on s0 .. s<degree-1>, weight 1/(i+1); stopping weighs as much as all loops / 30
+        std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> loops {};
+        std::set<Symbol> alphabet {};
+        for (int i = 0; i < degree; ++i)
+        {
+            alphabet.insert("s" + std::to_string(i));
+            loops[{"S", "s" + std::to_string(i)}] = {"S"};
+        }
+        const FiniteAutomaton plain {{"S"}, alphabet, loops, "S", {"S"}};
+        std::vector<double> weights(plain.transitionCount());
+        double total {0};
+        for (std::size_t i = 0; i < weights.size(); ++i)
+        {
+            // rows are sorted by symbol id, which follows the alphabet's name order
+            const Symbol& name {plain.symbols().name(plain.transitionsBegin(0)[i].symbol)};
+            weights[i] = 1.0 / (std::stoi(name.substr(1)) + 1);
+            total += weights[i];
+        }
+        const FiniteAutomaton weighted {plain.withWeights(weights, {total / 30})};
+
+        constexpr std::size_t WORDS {200'000};
+        WordGenerator alias {weighted, 9, 1000};
+        std::size_t aliasBytes {0};
+        auto start = Clock::now();
+        alias.generate(WORDS, [&](std::string_view w) { aliasBytes += w.size(); });
+        const double aliasSeconds {secondsSince(start)};
+
+        // the same walk choosing by a linear scan of cumulative weights
+        std::vector<double> cumulative(weights.size() + 1);
+        std::partial_sum(weights.begin(), weights.end(), cumulative.begin());
+        cumulative.back() = cumulative[weights.size() - 1] + total / 30;
+        Xoshiro256 rng {9};
+        std::size_t scanBytes {0};
+        std::string word {};
+        start = Clock::now();
+        for (std::size_t i = 0; i < WORDS; ++i)
+        {
+            word.clear();
+            for (int steps = 0; steps < 1000; ++steps)
+            {
+                const double x {static_cast<double>(rng() >> 11) * 0x1.0p-53 * cumulative.back()};
+                std::size_t k {0};
+                while (k + 1 < cumulative.size() && cumulative[k] <= x)
+                    ++k;
+                if (k == weights.size())
+                    break;
+                word += plain.symbols().name(plain.transitionsBegin(0)[k].symbol);
+            }
+            scanBytes += word.size();
+        }
+        const double scanSeconds {secondsSince(start)};
+        std::cout << "out-degree " << degree << ": alias " << aliasBytes / aliasSeconds / 1e6 << " MB/s, linear scan "
+                  << scanBytes / scanSeconds / 1e6 << " MB/s\n";
+    }
+
+    std::cout << "\n== uniform exact-length sampling ==\n";
+    {
+        auto report = [](const char* name, const FiniteAutomaton& fa, std::size_t n, std::size_t samples) {
+            auto start = Clock::now();
+            const UniformSampler sampler {fa, n};
+            const double buildSeconds {secondsSince(start)};
+            Xoshiro256 rng {5};
+            std::string word {};
+            std::size_t bytes {0};
+            start = Clock::now();
+            for (std::size_t i = 0; i < samples; ++i)
+            {
+                word.clear();
+                sampler.sample(n, rng, word);
+                bytes += word.size();
+            }
+            const double sampleSeconds {secondsSince(start)};
+            std::cout << name << ", n = " << n << ": " << sampler.countWords(n).bitLength() << "-bit count, table "
+                      << sampler.tableBytes() / 1024 << " KiB built in " << buildSeconds * 1e3 << " ms; "
+                      << samples / sampleSeconds << " words/s (" << bytes / sampleSeconds / 1e6 << " MB/s)\n";
+        };
+        const FiniteAutomaton variant {variantGrammar().toFiniteAutomaton()};
+        report("Lab1 variant", variant, 100, 200'000);
+        report("Lab1 variant", variant, 1000, 20'000);
+        report("Lab1 variant", variant, 4000, 2'000);
+        report("keyword NFA (1285-state DFA)", keywordNFA("abcd", 200, 10), 256, 20'000);
+    }
+
+    std::cout << "\n== shortlex enumeration ==\n";
+    {
+        auto report = [](const char* name, const FiniteAutomaton& fa, std::size_t maxLength, std::size_t limit) {
+            auto start = Clock::now();
+            ShortlexEnumerator words {fa, maxLength};
+            std::string word {};
+            words.next(word);
+            const double firstSeconds {secondsSince(start)};
+            std::size_t count {1}, bytes {word.size()};
+            start = Clock::now();
+            while (count < limit && words.next(word))
+            {
+                ++count;
+                bytes += word.size();
+            }
+            const double seconds {secondsSince(start)};
+            std::cout << name << ", up to " << maxLength << " symbols: first word after " << firstSeconds * 1e3
+                      << " ms; " << count << " words (" << bytes << " bytes, last " << words.currentLength()
+                      << " symbols) at " << count / seconds / 1e6 << " Mwords/s\n";
+        };
+        const FiniteAutomaton variant {variantGrammar().toFiniteAutomaton()};
+        report("Lab1 variant", variant, 12, 50'000'000);
+        report("Lab1 variant", variant, 4000, 20'000'000);
+        report("(a|b)*, 2^61 words", FiniteAutomaton::fromText("%initial S\n%final S\nS a S\nS b S\n"), 60,
+               20'000'000);
+
+        // generate-and-test: every string over {a..f} in shortlex order, kept when accepted
+        const std::size_t naiveLength {7};
+        std::size_t accepted {0};
+        std::string word {};
+        auto start = Clock::now();
+        for (std::size_t n = 0; n <= naiveLength; ++n)
+        {
+            word.assign(n, 'a');
+            while (true)
+            {
+                accepted += variant.stringBelongsToLanguage(word);
+                std::size_t i {n};
+                while (i > 0 && word[i - 1] == 'f')
+                    word[--i] = 'a';
+                if (i == 0)
+                    break;
+                ++word[i - 1];
+            }
+        }
+        const double naiveSeconds {secondsSince(start)};
+        ShortlexEnumerator words {variant, naiveLength};
+        std::size_t enumerated {0};
+        start = Clock::now();
+        while (words.next(word))
+            ++enumerated;
+        std::cout << "Lab1 variant, up to " << naiveLength << " symbols: generate-and-test " << naiveSeconds * 1e3
+                  << " ms, enumerator " << secondsSince(start) * 1e3 << " ms (" << accepted << " / " << enumerated
+                  << " words)\n";
+    }
+
+    std::cout << "\n== approximate matching ==\n";
+    {
+        // accepted words with one or two random edits
+        const FiniteAutomaton variant {variantGrammar().toFiniteAutomaton()};
+        const FiniteAutomaton dfa {variant.toDFA(true)};
+        WordGenerator generator {variant, 3};
+        std::mt19937 mt {3};
+        const std::string letters {"abcdefg"};
+        std::vector<std::string> inputs(200'000);
+        std::size_t bytes {0};
+        for (auto& input : inputs)
+        {
+            generator.next(input);
+            for (int edits = 1 + static_cast<int>(mt() % 2); edits > 0 && !input.empty(); --edits)
+            {
+                const std::size_t at {mt() % input.size()};
+                switch (mt() % 3)
+                {
+                case 0: input.erase(at, 1); break;
+                case 1: input.insert(at, 1, letters[mt() % letters.size()]); break;
+                default: input[at] = letters[mt() % letters.size()]; break;
+                }
+            }
+            bytes += input.size();
+        }
+
+        // today's way for k = 1: every single-byte edit over {a..f}, matched one by one
+        std::size_t bruteHits {0};
+        auto start = Clock::now();
+        std::string edited {};
+        for (const auto& input : inputs)
+        {
+            bool hit {dfa.stringBelongsToLanguage(input)};
+            for (std::size_t i = 0; i <= input.size() && !hit; ++i)
+            {
+                if (i < input.size())
+                {
+                    edited = input;
+                    edited.erase(i, 1);
+                    hit = dfa.stringBelongsToLanguage(edited);
+                }
+                for (std::size_t c = 0; c < 6 && !hit; ++c)
+                {
+                    edited = input;
+                    edited.insert(i, 1, letters[c]);
+                    hit = dfa.stringBelongsToLanguage(edited);
+                    if (!hit && i < input.size())
+                    {
+                        edited = input;
+                        edited[i] = letters[c];
+                        hit = dfa.stringBelongsToLanguage(edited);
+                    }
+                }
+            }
+            bruteHits += hit;
+        }
+        std::cout << "Lab1 variant, " << inputs.size() << " typo'd words: brute force k = 1 "
+                  << bytes / secondsSince(start) / 1e6 << " MB/s (" << bruteHits << " hits)\n";
+
+        auto report = [&](const char* name, const FiniteAutomaton& fa, const std::vector<std::string>& inputs,
+                          std::size_t k) {
+            const ApproximateMatcher matcher {fa.approximateMatcher(k)};
+            std::size_t total {0}, hits {0}, distances {0};
+            auto start = Clock::now();
+            for (const auto& input : inputs)
+            {
+                const std::size_t d {matcher.distance(input)};
+                total += input.size();
+                if (d != ApproximateMatcher::NPOS)
+                {
+                    ++hits;
+                    distances += d;
+                }
+            }
+            std::cout << name << " (" << matcher.stateCount() << " states), k = " << k << ": "
+                      << total / secondsSince(start) / 1e6 << " MB/s (" << hits << " hits, distance sum " << distances
+                      << ")\n";
+        };
+        for (std::size_t k : {0, 1, 2, 3})
+            report("Lab1 variant NFA", variant, inputs, k);
+        report("Lab1 variant DFA", dfa, inputs, 2);
+        const auto keywordInputs = randomWords("abcd", 20'000, 64);
+        for (std::size_t k : {1, 2})
+            report("keyword NFA", keywordNFA("abcd", 200, 10), keywordInputs, k);
+    }
+
+    std::cout << "\n== matchBatch (Lab1 variant DFA, 4M strings) ==\n";
+    {
+        FiniteAutomaton dfa = variantGrammar().toFiniteAutomaton().toDFA(true);
+        auto words = randomWords("abcdef", 4'000'000, 24);
+        std::vector<std::string_view> views(words.begin(), words.end());
+        std::vector<std::uint8_t> out;
+        unsigned maxThreads = std::max(4U, std::thread::hardware_concurrency());
+        for (unsigned interleave : {1U, 4U})
+            for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+            {
+                auto start = Clock::now();
+                dfa.matchBatch(views, out, {threads, interleave});
+                double rate = views.size() / secondsSince(start);
+                std::cout << "threads " << threads << ", interleave " << interleave << ": "
+                          << rate / 1e6 << " Mstr/s\n";
+            }
+    }
+
+    std::cout << "\n== text loader ==\n";
+    {
+        // 200k states with 10 random transitions each
+        std::mt19937 mt{7};
+        std::uniform_int_distribution<int> state(0, 199'999);
+        std::string text {"%initial s0\n%final s1 s2 s3\n"};
+        for (int s = 0; s < 200'000; ++s)
+            for (char c = 'a'; c < 'k'; ++c)
+                text += "s" + std::to_string(s) + ' ' + c + " s" + std::to_string(state(mt)) + '\n';
+        const std::string path {(std::filesystem::temp_directory_path() / "lfa_bench.txt").string()};
+        std::ofstream{path, std::ios::binary} << text;
+
+        auto start = Clock::now();
+        std::size_t before = g_liveBytes;
+        FiniteAutomaton fa = FiniteAutomaton::loadText(path);
+        double seconds = secondsSince(start);
+        std::cout << "loadText: " << fa.transitionCount() << " transitions, " << text.size() / (1 << 20) << " MiB in "
+                  << seconds * 1e3 << " ms (" << text.size() / seconds / (1 << 20) << " MiB/s), "
+                  << (g_liveBytes - before) / 1024 << " KiB\n";
+        std::filesystem::remove(path);
+    }
+
+    std::cout << "\n== lazy DFA (keyword NFA, 2001 states) ==\n";
+    {
+        FiniteAutomaton nfa = keywordNFA("abcd", 200, 10);
+        auto words = randomWords("abcd", 200'000, 64);
+        for (size_t cache : {size_t{16} << 10, size_t{256} << 10, size_t{4} << 20})
+        {
+            LazyDFA lazy = nfa.lazyDFA(cache);
+            size_t accepted{};
+            auto start = Clock::now();
+            for (const auto& w : words)
+                accepted += lazy.matches(w);
+            double rate = words.size() / secondsSince(start);
+            auto st = lazy.stats();
+            std::cout << "cache " << (cache >> 10) << " KiB: " << rate / 1e6 << " Mstr/s, hits " << st.hits
+                      << ", misses " << st.misses << ", flushes " << st.flushes << ", states " << st.states
+                      << ", bytes " << st.bytes << " (accepted " << accepted << ")\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "approximateMatcher.h"
+#include "denseNFA.h"
+#include <algorithm>
+
+ApproximateMatcher::ApproximateMatcher(const FiniteAutomaton& fa, std::size_t maxEdits)
+    : m_maxEdits {maxEdits}
+{
+    DenseNFA dense {fa};
+    const std::size_t n {dense.stateCount()};
+    m_stateCount = n;
+    m_words = dense.words;
+    m_final = dense.finals;
+
+    const std::vector<std::uint64_t> live {dense.liveStates()};
+    auto isLive = [&](std::uint32_t s) { return (live[s / 64] >> (s % 64)) & 1U; };
+    m_start = dense.start;
+    for (std::size_t w = 0; w < m_words; ++w)
+        m_start[w] &= live[w];
+
+    // single-byte symbols only, as in BitParallelNFA; the last column is "any symbol"
+    m_column.fill(-1);
+    std::vector<std::size_t> columnSymbol {};
+    for (std::size_t a = 0; a < dense.symbolCount(); ++a)
+    {
+        if (dense.symbols[a].size() != 1)
+            continue;
+        m_column[static_cast<unsigned char>(dense.symbols[a][0])] = static_cast<std::int32_t>(m_symbolCount++);
+        columnSymbol.push_back(a);
+    }
+    const std::size_t columns {m_symbolCount + 1};
+
+    // live successors of (column, state) into `out`
+    auto successors = [&](std::size_t col, std::size_t s, auto&& out) {
+        const std::size_t first {col == m_symbolCount ? 0 : col};
+        const std::size_t last {col == m_symbolCount ? m_symbolCount : col + 1};
+        for (std::size_t c = first; c < last; ++c)
+            for (auto it = dense.succBegin(columnSymbol[c], s); it != dense.succEnd(columnSymbol[c], s); ++it)
+                if (isLive(*it))
+                    out(*it);
+    };
+
+    if (n <= 64)
+    {
+        m_chunks = (n + 3) / 4;
+        m_nibbles.assign(columns * m_chunks * 16, 0);
+        for (std::size_t col = 0; col < columns; ++col)
+            for (std::size_t s = 0; s < n; ++s)
+            {
+                std::uint64_t mask {0};
+                successors(col, s, [&](std::uint32_t t) { mask |= std::uint64_t{1} << t; });
+                // every nibble value with bit (s % 4) set gets s's successors
+                std::uint64_t* table {m_nibbles.data() + (col * m_chunks + s / 4) * 16};
+                for (std::size_t x = 0; x < 16; ++x)
+                    if ((x >> (s % 4)) & 1)
+                        table[x] |= mask;
+            }
+        return;
+    }
+
+    m_offsets.assign(columns * n + 1, 0);
+    std::vector<std::uint64_t> seen(m_words);
+    for (std::size_t col = 0; col < columns; ++col)
+        for (std::size_t s = 0; s < n; ++s)
+        {
+            // the any column would repeat a target once per symbol leading to it
+            const std::size_t first {m_targets.size()};
+            successors(col, s, [&](std::uint32_t t) {
+                if (!((seen[t / 64] >> (t % 64)) & 1))
+                {
+                    seen[t / 64] |= std::uint64_t{1} << (t % 64);
+                    m_targets.push_back(t);
+                }
+            });
+            for (std::size_t i = first; i < m_targets.size(); ++i)
+                seen[m_targets[i] / 64] = 0;
+            m_offsets[col * n + s + 1] = static_cast<std::uint32_t>(m_targets.size());
+        }
+}
+
+std::size_t ApproximateMatcher::distance(std::string_view input) const
+{
+    if (m_stateCount == 0)
+        return NPOS;
+    return m_stateCount <= 64 ? distanceSmall(input) : distanceLarge(input);
+}
+
+std::size_t ApproximateMatcher::distanceSmall(std::string_view input) const
+{
+    const std::size_t k {m_maxEdits};
+    const std::size_t any {m_symbolCount};
+    std::vector<std::uint64_t> sets(k + 1);
+    // before any input: d symbols added up front
+    sets[0] = m_start[0];
+    for (std::size_t d = 1; d <= k; ++d)
+        sets[d] = sets[d - 1] | stepSmall(any, sets[d - 1]);
+
+    for (unsigned char c : input)
+    {
+        const std::int32_t column {m_column[c]};
+        std::uint64_t previous {sets[0]};   // R[d - 1] before this byte
+        sets[0] = column >= 0 ? stepSmall(static_cast<std::size_t>(column), sets[0]) : 0;
+        for (std::size_t d = 1; d <= k; ++d)
+        {
+            const std::uint64_t old {sets[d]};
+            std::uint64_t next {previous | stepSmall(any, previous | sets[d - 1])};
+            if (column >= 0)
+                next |= stepSmall(static_cast<std::size_t>(column), old);
+            sets[d] = next;
+            previous = old;
+        }
+        // sets grow with d, so an empty R[k] means every set is empty
+        if (!sets[k])
+            return NPOS;
+    }
+    for (std::size_t d = 0; d <= k; ++d)
+        if (sets[d] & m_final[0])
+            return d;
+    return NPOS;
+}
+
+void ApproximateMatcher::stepLarge(std::size_t column, const std::uint64_t* set, std::uint64_t* out) const
+{
+    const std::size_t base {column * m_stateCount};
+    for (std::size_t w = 0; w < m_words; ++w)
+        for (std::uint64_t bits = set[w]; bits; bits &= bits - 1)
+        {
+            const std::size_t i {base + w * 64 + __builtin_ctzll(bits)};
+            for (std::uint32_t t = m_offsets[i]; t < m_offsets[i + 1]; ++t)
+                out[m_targets[t] / 64] |= std::uint64_t{1} << (m_targets[t] % 64);
+        }
+}
+
+std::size_t ApproximateMatcher::distanceLarge(std::string_view input) const
+{
+    const std::size_t k {m_maxEdits};
+    const std::size_t any {m_symbolCount};
+    const std::size_t words {m_words};
+    // R[d] at sets[d * words], three more sets for the old R[d - 1] and R[d] and a union
+    std::vector<std::uint64_t> sets((k + 4) * words, 0);
+    std::uint64_t* previous {sets.data() + (k + 1) * words};
+    std::uint64_t* old {sets.data() + (k + 2) * words};
+    std::uint64_t* both {sets.data() + (k + 3) * words};
+    auto row = [&](std::size_t d) { return sets.data() + d * words; };
+    auto isEmpty = [&](const std::uint64_t* set) {
+        return std::all_of(set, set + words, [](std::uint64_t w) { return w == 0; });
+    };
+
+    std::copy(m_start.begin(), m_start.end(), row(0));
+    for (std::size_t d = 1; d <= k; ++d)
+    {
+        std::copy(row(d - 1), row(d - 1) + words, row(d));
+        stepLarge(any, row(d - 1), row(d));
+    }
+
+    for (unsigned char c : input)
+    {
+        const std::int32_t column {m_column[c]};
+        std::copy(row(0), row(0) + words, previous);
+        std::fill(row(0), row(0) + words, 0);
+        if (column >= 0)
+            stepLarge(static_cast<std::size_t>(column), previous, row(0));
+        for (std::size_t d = 1; d <= k; ++d)
+        {
+            std::copy(row(d), row(d) + words, old);
+            std::copy(previous, previous + words, row(d));
+            for (std::size_t w = 0; w < words; ++w)
+                both[w] = previous[w] | row(d - 1)[w];
+            stepLarge(any, both, row(d));
+            if (column >= 0)
+                stepLarge(static_cast<std::size_t>(column), old, row(d));
+            std::swap(previous, old);
+        }
+        if (isEmpty(row(k)))
+            return NPOS;
+    }
+    for (std::size_t d = 0; d <= k; ++d)
+        for (std::size_t w = 0; w < words; ++w)
+            if (row(d)[w] & m_final[w])
+                return d;
+    return NPOS;
+}
+
+std::size_t ApproximateMatcher::tableBytes() const
+{
+    return sizeof(m_column) + m_nibbles.size() * sizeof(std::uint64_t)
+        + (m_offsets.size() + m_targets.size()) * sizeof(std::uint32_t)
+        + (m_start.size() + m_final.size()) * sizeof(std::uint64_t);
+}
@@ -0,0 +1,81 @@
+#ifndef APPROXIMATE_MATCHER_H
+#define APPROXIMATE_MATCHER_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+class FiniteAutomaton;
+
+// Edit distance from an input to the language: the fewest single-byte
+// insertions, deletions and substitutions that turn it into an accepted word,
+// up to maxEdits. This is Wu-Manber's bit-parallel matcher with the pattern
+// replaced by the automaton, i.e. its product with a Levenshtein automaton:
+// R[d] is the set of states reached by the input so far with at most d edits,
+// and a byte c updates them from the old sets R and new sets R' by
+//
+//   R'[0] = step(R[0], c)
+//   R'[d] = step(R[d], c) | R[d-1] | any(R[d-1]) | any(R'[d-1])
+//
+// (match, dropping c, replacing c, adding a symbol before it), with any() the
+// step on every symbol. Like BitParallelNFA, symbols are single bytes,
+// epsilon closures are folded in (see DenseNFA) and states that cannot reach
+// a final state are dropped. Up to 64 states a set is one uint64_t and a step
+// is a lookup per 4 states in per-column nibble tables, so a byte costs
+// O(k * states / 4) whatever is active; above that sets are bitsets and a
+// step walks the successors of active states.
+class ApproximateMatcher
+{
+public:
+    static constexpr std::size_t NPOS {static_cast<std::size_t>(-1)};
+
+    ApproximateMatcher(const FiniteAutomaton& fa, std::size_t maxEdits);
+
+    // NPOS when the input is more than maxEdits() edits away
+    std::size_t distance(std::string_view input) const;
+    bool matches(std::string_view input) const { return distance(input) != NPOS; }
+
+    //getters
+    std::size_t maxEdits() const { return m_maxEdits; }
+    std::size_t stateCount() const { return m_stateCount; }
+    std::size_t tableBytes() const;
+
+private:
+    // successors of `set` on column `column` (m_symbolCount: any symbol), <= 64 states
+    std::uint64_t stepSmall(std::size_t column, std::uint64_t set) const
+    {
+        const std::uint64_t* table {m_nibbles.data() + column * m_chunks * 16};
+        std::uint64_t out {0};
+        for (std::size_t i = 0; set; ++i, set >>= 4)
+            out |= table[i * 16 + (set & 15)];
+        return out;
+    }
+    // out |= successors of `set` on `column`, > 64 states
+    void stepLarge(std::size_t column, const std::uint64_t* set, std::uint64_t* out) const;
+
+    std::size_t distanceSmall(std::string_view input) const;
+    std::size_t distanceLarge(std::string_view input) const;
+
+    std::size_t m_maxEdits {0};
+    std::size_t m_stateCount {0};
+    std::size_t m_symbolCount {0};
+    std::size_t m_words {0};                   // 64-bit words per state set
+    std::array<std::int32_t, 256> m_column {}; // byte -> symbol column, -1 if unused
+
+    // <= 64 states: m_nibbles[(column * m_chunks + i) * 16 + x], the successors of
+    // the states 4i + j for the bits j set in x
+    std::size_t m_chunks {0};
+    std::vector<std::uint64_t> m_nibbles {};
+
+    // > 64 states: successors of (column, state) are
+    // m_targets[m_offsets[i] .. m_offsets[i + 1]) with i = column * stateCount + state
+    std::vector<std::uint32_t> m_offsets {};
+    std::vector<std::uint32_t> m_targets {};
+
+    std::vector<std::uint64_t> m_start {};     // epsilon closure of the initial state
+    std::vector<std::uint64_t> m_final {};
+};
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef BASIC_DFA_H
+#define BASIC_DFA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include "compiledDFA.h"
+#include "finiteAutomaton.h"
+
+// Compiled DFA table generic over the state id width and the input symbol
+// type: chars, small integers or an enum such as Lab3's TokenType.
+//
+// Symbol names of the FiniteAutomaton are turned into SymbolT values by a
+// `symbolOf(const Symbol&) -> std::optional<SymbolT>` callable; transitions on
+// names it rejects are dropped. Symbols no transition tells apart share a class
+// and the table has one StateT per (state, class), rows padded to a power of two.
+// State 0 is dead, and states that cannot reach a final state are folded into it.
+// Non-deterministic automata are determinized first.
+//
+// Symbols map to classes through a dense array over the range of keys in use
+// when that range is small (at most DENSE_KEYS, or four slots per key), and
+// otherwise through a sorted key array searched by bisection, so sparse
+// 32-bit token ids cost memory per key rather than per value of the range.
+//
+// A StateT must be able to hold stateCount() - 1; see AutoDFA for picking the
+// narrowest width at run time.
+template <class StateT, class SymbolT>
+class BasicDFA
+{
+    static_assert(std::is_unsigned_v<StateT>, "state ids are unsigned integers");
+
+public:
+    using StateId = StateT;
+    using SymbolType = SymbolT;
+    static constexpr StateT DEAD {0};
+    static constexpr std::size_t DENSE_KEYS {std::size_t{1} << 16};
+
+    // default symbolOf: single-character names, for char-like SymbolT
+    explicit BasicDFA(const FiniteAutomaton& fa)
+        : BasicDFA(fa, [](const Symbol& name) -> std::optional<SymbolT> {
+              if (name.size() != 1)
+                  return std::nullopt;
+              return static_cast<SymbolT>(name[0]);
+          })
+    {
+    }
+
+    template <class SymbolOf>
+    BasicDFA(const FiniteAutomaton& fa, SymbolOf symbolOf)
+    {
+        if (CompiledDFA::canCompile(fa))
+            build(fa, symbolOf);
+        else
+            build(fa.toDFA(), symbolOf);
+    }
+
+    // true if the automaton fits in StateT
+    static bool fits(const FiniteAutomaton& dfa)
+    {
+        return dfa.stateCount() <= std::numeric_limits<StateT>::max();
+    }
+
+    template <class It>
+    bool matches(It first, It last) const
+    {
+        const StateT* table {m_table.data()};
+        std::size_t s {m_start};
+        for (; first != last; ++first)
+            s = table[(s << m_shift) + classOf(*first)];
+        return isFinal(static_cast<StateT>(s));
+    }
+    // any range of SymbolT: std::string_view, std::vector<TokenType>, ...
+    template <class Range>
+    bool matches(const Range& input) const
+    {
+        return matches(std::begin(input), std::end(input));
+    }
+
+    //getters
+    StateT startState() const { return m_start; }
+    StateT next(StateT s, SymbolT symbol) const { return m_table[(std::size_t{s} << m_shift) + classOf(symbol)]; }
+    bool isFinal(StateT s) const { return m_final[s] != 0; }
+    std::size_t stateCount() const { return m_final.size(); }
+    std::size_t classCount() const { return m_classCount; }
+    std::size_t tableBytes() const
+    {
+        return m_table.size() * sizeof(StateT) + m_classOf.size() * sizeof(std::uint16_t)
+            + m_keys.size() * sizeof(std::int64_t) + m_final.size();
+    }
+    // true if symbols are looked up in the sorted key array
+    bool isSparse() const { return !m_keys.empty(); }
+
+private:
+    // symbols as integers, bytes taken as unsigned
+    static std::int64_t keyOf(SymbolT symbol)
+    {
+        if constexpr (std::is_enum_v<SymbolT>)
+            return static_cast<std::int64_t>(static_cast<std::underlying_type_t<SymbolT>>(symbol));
+        else if constexpr (sizeof(SymbolT) == 1)
+            return static_cast<unsigned char>(symbol);
+        else
+            return static_cast<std::int64_t>(symbol);
+    }
+
+    std::size_t classOf(SymbolT symbol) const
+    {
+        const std::int64_t key {keyOf(symbol)};
+        if (!m_keys.empty())
+        {
+            const auto it {std::lower_bound(m_keys.begin(), m_keys.end(), key)};
+            return it != m_keys.end() && *it == key ? m_classOf[static_cast<std::size_t>(it - m_keys.begin())] : 0;
+        }
+        // keys outside [m_lo, m_lo + size) wrap around to huge values
+        const auto i {static_cast<std::uint64_t>(key - m_lo)};
+        return i < m_classOf.size() ? m_classOf[i] : 0;
+    }
+
+    template <class SymbolOf>
+    void build(const FiniteAutomaton& fa, SymbolOf& symbolOf)
+    {
+        const std::size_t count {fa.stateCount() + 1};
+        if (count - 1 > std::numeric_limits<StateT>::max())
+            throw std::length_error("BasicDFA: " + std::to_string(count) + " states do not fit the state type");
+
+        // dense ids: 0 is dead, state index i is id i + 1; edges carry symbol keys,
+        // and once the key map is laid out, their slot in m_classOf
+        struct Edge { std::int64_t key; std::uint32_t to; std::size_t slot; };
+        std::vector<std::optional<std::int64_t>> keyOfName(fa.symbols().size());
+        std::vector<bool> resolved(fa.symbols().size(), false);
+        std::vector<std::uint32_t> offsets(count + 1, 0);
+        std::vector<Edge> edges {};
+        for (std::size_t s = 0; s < fa.stateCount(); ++s)
+        {
+            for (auto t = fa.transitionsBegin(s); t != fa.transitionsEnd(s); ++t)
+            {
+                if (!resolved[t->symbol])
+                {
+                    resolved[t->symbol] = true;
+                    if (std::optional<SymbolT> symbol = symbolOf(fa.symbols().name(t->symbol)))
+                        keyOfName[t->symbol] = keyOf(*symbol);
+                }
+                if (keyOfName[t->symbol])
+                    edges.push_back({*keyOfName[t->symbol], t->to + 1, 0});
+            }
+            offsets[s + 2] = static_cast<std::uint32_t>(edges.size());
+        }
+        m_final.assign(count, 0);
+        for (std::size_t s = 0; s < fa.stateCount(); ++s)
+            m_final[s + 1] = fa.isFinal(s);
+
+        // liveness: states that cannot reach a final state behave like DEAD
+        std::vector<std::vector<std::uint32_t>> predecessors(count);
+        for (std::uint32_t q = 1; q < count; ++q)
+            for (std::uint32_t e = offsets[q]; e < offsets[q + 1]; ++e)
+                predecessors[edges[e].to].push_back(q);
+        std::vector<bool> live(count, false);
+        std::vector<std::uint32_t> stack {};
+        for (std::uint32_t q = 1; q < count; ++q)
+            if (m_final[q])
+            {
+                live[q] = true;
+                stack.push_back(q);
+            }
+        while (!stack.empty())
+        {
+            std::uint32_t q {stack.back()};
+            stack.pop_back();
+            for (std::uint32_t p : predecessors[q])
+                if (!live[p])
+                {
+                    live[p] = true;
+                    stack.push_back(p);
+                }
+        }
+        for (auto& e : edges)
+            if (!live[e.to])
+                e.to = DEAD;
+
+        // symbol classes over the keys in use, refined as in CompiledDFA; class 0
+        // also holds every key outside the map, so it never moves whole
+        m_lo = 0;
+        m_keys.clear();
+        std::vector<std::int64_t> keys {};
+        for (const auto& e : edges)
+            keys.push_back(e.key);
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        std::size_t slots {0};
+        if (!keys.empty())
+        {
+            const std::uint64_t range {static_cast<std::uint64_t>(keys.back()) - static_cast<std::uint64_t>(keys.front()) + 1};
+            if (range <= std::max<std::uint64_t>(DENSE_KEYS, 4 * keys.size()))
+            {
+                m_lo = keys.front();
+                slots = static_cast<std::size_t>(range);
+                for (auto& e : edges)
+                    e.slot = static_cast<std::size_t>(e.key - m_lo);
+            }
+            else
+            {
+                m_keys = keys;
+                slots = keys.size();
+                for (auto& e : edges)
+                    e.slot = static_cast<std::size_t>(std::lower_bound(keys.begin(), keys.end(), e.key) - keys.begin());
+            }
+        }
+        m_classOf.assign(slots, 0);
+        std::vector<std::size_t> classSize {m_classOf.size() + 1};
+        std::vector<Edge> row {};
+        auto slot = [&](const Edge& e) -> std::uint16_t& { return m_classOf[e.slot]; };
+        for (std::uint32_t q = 1; q < count; ++q)
+        {
+            if (!live[q])
+                continue;
+            row.clear();
+            for (std::uint32_t e = offsets[q]; e < offsets[q + 1]; ++e)
+                if (edges[e].to != DEAD)
+                    row.push_back(edges[e]);
+            auto groupKey = [&](const Edge& e) { return (std::uint64_t{slot(e)} << 32) | e.to; };
+            std::sort(row.begin(), row.end(), [&](const Edge& a, const Edge& b) { return groupKey(a) < groupKey(b); });
+            for (std::size_t i = 0, j = 0; i < row.size(); i = j)
+            {
+                while (j < row.size() && groupKey(row[j]) == groupKey(row[i]))
+                    ++j;
+                const std::uint16_t old {slot(row[i])};
+                if (j - i == classSize[old])
+                    continue;
+                if (classSize.size() > std::numeric_limits<std::uint16_t>::max())
+                    throw std::length_error("BasicDFA: more than 65535 symbol classes");
+                const auto fresh {static_cast<std::uint16_t>(classSize.size())};
+                for (std::size_t k = i; k < j; ++k)
+                    slot(row[k]) = fresh;
+                classSize[old] -= j - i;
+                classSize.push_back(j - i);
+            }
+        }
+        m_classCount = classSize.size();
+
+        m_shift = 0;
+        while ((std::size_t{1} << m_shift) < m_classCount)
+            ++m_shift;
+        m_table.assign(count << m_shift, DEAD);
+        for (std::uint32_t q = 1; q < count; ++q)
+            if (live[q])
+                for (std::uint32_t e = offsets[q]; e < offsets[q + 1]; ++e)
+                    m_table[(std::size_t{q} << m_shift) + slot(edges[e])] = static_cast<StateT>(edges[e].to);
+        m_start = live[fa.initialIndex() + 1] ? static_cast<StateT>(fa.initialIndex() + 1) : DEAD;
+    }
+
+    std::vector<StateT> m_table {};           // stateCount << shift
+    std::vector<std::uint16_t> m_classOf {};  // key - m_lo, or the key's index in m_keys -> class
+    std::vector<std::int64_t> m_keys {};      // sorted keys in use when sparse, else empty
+    std::vector<std::uint8_t> m_final {};
+    std::int64_t m_lo {0};
+    std::size_t m_classCount {1};
+    unsigned m_shift {0};
+    StateT m_start {DEAD};
+};
+
+// BasicDFA with the narrowest state width that fits: uint8_t up to 255
+// states, then uint16_t, then uint32_t.
+template <class SymbolT>
+class AutoDFA
+{
+public:
+    explicit AutoDFA(const FiniteAutomaton& fa)
+        : AutoDFA(fa, [](const Symbol& name) -> std::optional<SymbolT> {
+              if (name.size() != 1)
+                  return std::nullopt;
+              return static_cast<SymbolT>(name[0]);
+          })
+    {
+    }
+
+    template <class SymbolOf>
+    AutoDFA(const FiniteAutomaton& fa, SymbolOf symbolOf)
+        : m_dfa {select(CompiledDFA::canCompile(fa) ? fa : fa.toDFA(), symbolOf)}
+    {
+    }
+
+    template <class Range>
+    bool matches(const Range& input) const
+    {
+        return std::visit([&](const auto& dfa) { return dfa.matches(input); }, m_dfa);
+    }
+
+    //getters
+    std::size_t stateBytes() const { return std::visit([](const auto& dfa) { return sizeof(typename std::decay_t<decltype(dfa)>::StateId); }, m_dfa); }
+    std::size_t stateCount() const { return std::visit([](const auto& dfa) { return dfa.stateCount(); }, m_dfa); }
+    std::size_t classCount() const { return std::visit([](const auto& dfa) { return dfa.classCount(); }, m_dfa); }
+    std::size_t tableBytes() const { return std::visit([](const auto& dfa) { return dfa.tableBytes(); }, m_dfa); }
+
+private:
+    using Variant = std::variant<BasicDFA<std::uint8_t, SymbolT>, BasicDFA<std::uint16_t, SymbolT>,
+                                 BasicDFA<std::uint32_t, SymbolT>>;
+
+    template <class SymbolOf>
+    static Variant select(const FiniteAutomaton& dfa, SymbolOf& symbolOf)
+    {
+        if (BasicDFA<std::uint8_t, SymbolT>::fits(dfa))
+            return BasicDFA<std::uint8_t, SymbolT>(dfa, symbolOf);
+        if (BasicDFA<std::uint16_t, SymbolT>::fits(dfa))
+            return BasicDFA<std::uint16_t, SymbolT>(dfa, symbolOf);
+        return BasicDFA<std::uint32_t, SymbolT>(dfa, symbolOf);
+    }
+
+    Variant m_dfa;
+};
+
+#endif
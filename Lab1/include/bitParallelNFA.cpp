@@ -0,0 +1,154 @@
+#include "bitParallelNFA.h"
+#include "denseNFA.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+BitParallelNFA::BitParallelNFA(const FiniteAutomaton& fa)
+{
+    DenseNFA dense {fa};
+    const std::size_t n {dense.stateCount()};
+    m_stateCount = n;
+    m_words = dense.words;
+    m_final = dense.finals;
+
+    // states that cannot reach a final state are dropped from every set,
+    // so an empty active set means the input can no longer be accepted
+    const std::vector<std::uint64_t> live {dense.liveStates()};
+    auto isLive = [&](std::uint32_t s) { return (live[s / 64] >> (s % 64)) & 1U; };
+    m_start = dense.start;
+    for (std::size_t w = 0; w < m_words; ++w)
+        m_start[w] &= live[w];
+
+    // only single-character symbols can be matched byte by byte
+    m_column.fill(-1);
+    std::vector<std::size_t> columnSymbol {};
+    for (std::size_t a = 0; a < dense.symbolCount(); ++a)
+    {
+        if (dense.symbols[a].size() != 1)
+            continue;
+        m_column[static_cast<unsigned char>(dense.symbols[a][0])] = static_cast<std::int32_t>(m_symbolCount++);
+        columnSymbol.push_back(a);
+    }
+
+    if (n <= 64)
+    {
+        m_masks.assign(m_symbolCount * n, 0);
+        for (std::size_t col = 0; col < m_symbolCount; ++col)
+            for (std::size_t s = 0; s < n; ++s)
+                for (auto it = dense.succBegin(columnSymbol[col], s); it != dense.succEnd(columnSymbol[col], s); ++it)
+                    if (isLive(*it))
+                        m_masks[col * n + s] |= std::uint64_t{1} << *it;
+        return;
+    }
+
+    m_offsets.assign(m_symbolCount * n + 1, 0);
+    for (std::size_t col = 0; col < m_symbolCount; ++col)
+        for (std::size_t s = 0; s < n; ++s)
+        {
+            std::copy_if(dense.succBegin(columnSymbol[col], s), dense.succEnd(columnSymbol[col], s),
+                         std::back_inserter(m_targets), isLive);
+            m_offsets[col * n + s + 1] = static_cast<std::uint32_t>(m_targets.size());
+        }
+}
+
+bool BitParallelNFA::matches(std::string_view input) const
+{
+    if (m_stateCount == 0)
+        return false;
+    if (m_stateCount <= 64)
+    {
+        std::uint64_t active {m_start[0]};
+        return advanceSmall(active, input) && (active & m_final[0]) != 0;
+    }
+    // two sets per call, swapped every step (see advanceLarge)
+    std::vector<std::uint64_t> active {m_start};
+    std::vector<std::uint64_t> scratch(m_words);
+    return advanceLarge(active.data(), scratch.data(), input) && accepts(active.data());
+}
+
+void BitParallelNFA::reset(std::uint64_t* active) const
+{
+    std::copy(m_start.begin(), m_start.end(), active);
+}
+
+bool BitParallelNFA::advance(std::uint64_t* active, std::uint64_t* scratch, std::string_view chunk) const
+{
+    if (m_stateCount == 0)
+        return false;
+    if (m_stateCount <= 64)
+        return advanceSmall(active[0], chunk);
+    return advanceLarge(active, scratch, chunk);
+}
+
+bool BitParallelNFA::accepts(const std::uint64_t* active) const
+{
+    for (std::size_t w = 0; w < m_words; ++w)
+        if (active[w] & m_final[w])
+            return true;
+    return false;
+}
+
+bool BitParallelNFA::advanceSmall(std::uint64_t& active, std::string_view input) const
+{
+    const std::uint64_t* masks {m_masks.data()};
+    for (unsigned char c : input)
+    {
+        std::int32_t column {m_column[c]};
+        std::uint64_t next {0};
+        if (column >= 0)
+        {
+            const std::uint64_t* row {masks + column * m_stateCount};
+            for (std::uint64_t bits = active; bits; bits &= bits - 1)
+                next |= row[__builtin_ctzll(bits)];
+        }
+        active = next;
+        if (!next)
+            return false;
+    }
+    return active != 0;
+}
+
+bool BitParallelNFA::advanceLarge(std::uint64_t* active, std::uint64_t* scratch, std::string_view input) const
+{
+    // the two sets swap roles every step; the result is copied back into
+    // `active` once at the end if it finished in `scratch`
+    std::uint64_t* current {active};
+    std::uint64_t* next {scratch};
+    bool any {false};
+    for (std::size_t w = 0; w < m_words; ++w)
+        any |= current[w] != 0;
+    for (unsigned char c : input)
+    {
+        std::int32_t column {m_column[c]};
+        std::fill(next, next + m_words, 0);
+        any = false;
+        if (column >= 0)
+        {
+            const std::size_t base {column * m_stateCount};
+            for (std::size_t w = 0; w < m_words; ++w)
+            {
+                for (std::uint64_t bits = current[w]; bits; bits &= bits - 1)
+                {
+                    const std::size_t i {base + w * 64 + __builtin_ctzll(bits)};
+                    for (std::uint32_t k = m_offsets[i]; k < m_offsets[i + 1]; ++k)
+                        next[m_targets[k] / 64] |= std::uint64_t{1} << (m_targets[k] % 64);
+                    any |= m_offsets[i] != m_offsets[i + 1];
+                }
+            }
+        }
+        std::swap(current, next);
+        if (!any)
+            break;
+    }
+    if (current != active)
+        std::copy(current, current + m_words, active);
+    return any;
+}
+
+std::size_t BitParallelNFA::tableBytes() const
+{
+    return sizeof(m_column) + m_masks.size() * sizeof(std::uint64_t)
+        + (m_offsets.size() + m_targets.size()) * sizeof(std::uint32_t)
+        + (m_start.size() + m_final.size()) * sizeof(std::uint64_t);
+}
@@ -0,0 +1,60 @@
+#ifndef BIT_PARALLEL_NFA_H
+#define BIT_PARALLEL_NFA_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+class FiniteAutomaton;
+
+// Bit-parallel simulation of a (possibly epsilon-) NFA over dense state indices.
+// Epsilon closures are folded into the successor sets once at construction
+// (see DenseNFA), so a step is just the union of the precomputed successors
+// of active states.
+// Up to 64 states the active set lives in a single uint64_t; above that it is
+// a dynamic bitset and successors are kept as CSR lists. States that cannot
+// reach a final state are pruned, so an empty active set means a dead input.
+class BitParallelNFA
+{
+public:
+    explicit BitParallelNFA(const FiniteAutomaton& fa);
+    BitParallelNFA() = default;
+
+    bool matches(std::string_view input) const;
+
+    // streaming: `active` and `scratch` hold words() words each
+    void reset(std::uint64_t* active) const;
+    // feeds `chunk`; returns false once the active set is empty (dead)
+    bool advance(std::uint64_t* active, std::uint64_t* scratch, std::string_view chunk) const;
+    bool accepts(const std::uint64_t* active) const;
+
+    //getters
+    std::size_t stateCount() const { return m_stateCount; }
+    std::size_t symbolCount() const { return m_symbolCount; }
+    std::size_t words() const { return m_words; }
+    std::size_t tableBytes() const;
+
+private:
+    bool advanceSmall(std::uint64_t& active, std::string_view input) const;
+    bool advanceLarge(std::uint64_t* active, std::uint64_t* scratch, std::string_view input) const;
+
+    std::size_t m_stateCount {0};
+    std::size_t m_symbolCount {0};
+    std::size_t m_words {0};                 // 64-bit words per state set
+    std::array<std::int32_t, 256> m_column {}; // byte -> symbol column, -1 if unused
+
+    // <= 64 states: m_masks[column * stateCount + state]
+    std::vector<std::uint64_t> m_masks {};
+
+    // > 64 states: successors of (column, state) are
+    // m_targets[m_offsets[i] .. m_offsets[i + 1]) with i = column * stateCount + state
+    std::vector<std::uint32_t> m_offsets {};
+    std::vector<std::uint32_t> m_targets {};
+
+    std::vector<std::uint64_t> m_start {};   // epsilon closure of the initial state
+    std::vector<std::uint64_t> m_final {};
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "codeGenerator.h"
+#include "compiledDFA.h"
+#include <cctype>
+#include <ostream>
+#include <vector>
+
+namespace
+{
+    void writeCase(std::ostream& out, unsigned c)
+    {
+        out << "    case ";
+        if (std::isalnum(static_cast<int>(c)))
+            out << '\'' << static_cast<char>(c) << '\'';
+        else
+            out << c;
+        out << ":";
+    }
+}
+
+CodeGenerator::CodeGenerator(const FiniteAutomaton& fa, std::string functionName)
+    : m_dfa {fa.toDFA(true)}
+    , m_name {std::move(functionName)}
+{
+}
+
+std::size_t CodeGenerator::stateCount() const
+{
+    return m_dfa.compiledDFA()->stateCount() - 1;
+}
+
+void CodeGenerator::writeHeader(std::ostream& out) const
+{
+    out << "// Generated by lfagen; do not edit.\n"
+        << "#pragma once\n"
+        << "#include <string_view>\n\n"
+        << "bool " << m_name << "(std::string_view input) noexcept;\n";
+}
+
+void CodeGenerator::writeSource(std::ostream& out, const std::string& headerName) const
+{
+    const CompiledDFA& dfa {*m_dfa.compiledDFA()};
+    using StateId = CompiledDFA::StateId;
+
+    out << "// Generated by lfagen; do not edit.\n"
+        << "// " << stateCount() << " states, " << dfa.classCount() << " byte classes.\n"
+        << "#include \"" << headerName << "\"\n\n"
+        << "bool " << m_name << "(std::string_view input) noexcept\n{\n";
+    if (dfa.startState() == CompiledDFA::DEAD)
+    {
+        out << "    (void)input;\n    return false;\n}\n";
+        return;
+    }
+    out << "    const unsigned char* p {reinterpret_cast<const unsigned char*>(input.data())};\n"
+        << "    const unsigned char* const end {p + input.size()};\n"
+        << "    goto s" << dfa.indexOf(dfa.startState()) << ";\n";
+
+    // bytes of each class, so a state's cases can be listed per target
+    std::vector<std::vector<unsigned>> bytesOf(dfa.classCount());
+    for (unsigned c = 0; c < 256; ++c)
+        bytesOf[dfa.classOf(static_cast<unsigned char>(c))].push_back(c);
+
+    for (std::size_t q = 1; q < dfa.stateCount(); ++q)
+    {
+        const StateId row {dfa.rowOf(q)};
+        out << "s" << q << ":\n"
+            << "    if (p == end)\n"
+            << "        return " << (dfa.isFinal(row) ? "true" : "false") << ";\n"
+            << "    switch (*p++)\n    {\n";
+        for (std::size_t k = 0; k < dfa.classCount(); ++k)
+        {
+            if (bytesOf[k].empty())
+                continue;
+            const StateId next {dfa.next(row, static_cast<unsigned char>(bytesOf[k][0]))};
+            if (next == CompiledDFA::DEAD)
+                continue;
+            for (std::size_t i = 0; i < bytesOf[k].size(); ++i)
+            {
+                writeCase(out, bytesOf[k][i]);
+                out << (i + 1 < bytesOf[k].size() ? "\n" : " ");
+            }
+            out << "goto s" << dfa.indexOf(next) << ";\n";
+        }
+        out << "    default: return false;\n    }\n";
+    }
+    out << "}\n";
+}
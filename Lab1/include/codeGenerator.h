@@ -0,0 +1,31 @@
+#ifndef CODE_GENERATOR_H
+#define CODE_GENERATOR_H
+
+#include <iosfwd>
+#include <string>
+#include "finiteAutomaton.h"
+
+// Emits a standalone C++ matcher for a FiniteAutomaton, re2c style: the
+// automaton is determinized and minimized, and every DFA state becomes a
+// label whose `switch` on the next byte jumps straight to the next state.
+// The generated code only needs <string_view>, so it can be dropped into any
+// target without this library (see lfagen and the CMake rule that runs it).
+class CodeGenerator
+{
+public:
+    // `functionName` becomes `bool functionName(std::string_view) noexcept`
+    CodeGenerator(const FiniteAutomaton& fa, std::string functionName);
+
+    void writeHeader(std::ostream& out) const;
+    // `headerName` is the include path the source uses for the header
+    void writeSource(std::ostream& out, const std::string& headerName) const;
+
+    //getters
+    std::size_t stateCount() const;
+
+private:
+    FiniteAutomaton m_dfa {};
+    std::string m_name {};
+};
+
+#endif
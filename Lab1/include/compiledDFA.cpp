@@ -0,0 +1,539 @@
+#include "compiledDFA.h"
+#include "finiteAutomaton.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    struct OwnedTables
+    {
+        std::vector<CompiledDFA::StateId> table {};
+        std::vector<std::uint64_t> finalBits {};
+    };
+
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;    // BYTE_ORDER_MARK as written by this machine
+        std::uint32_t stateCount;
+        std::uint32_t classCount;
+        std::uint32_t shift;
+        std::uint32_t start;
+        std::uint64_t checksum;     // of every byte after the header
+        std::uint64_t reserved[3];
+    };
+    static_assert(sizeof(FileHeader) == 64, "the header is part of the file format");
+
+    constexpr char MAGIC[8] {'L', 'F', 'A', 'D', 'F', 'A', '\r', '\n'};
+    constexpr std::uint32_t BYTE_ORDER_MARK {0x01020304};
+
+    constexpr std::size_t ACCEL_BYTES {5};  // sizeof(CompiledDFA::Accel), checked in the class
+
+    // where each part of the payload starts; every array is 8-byte aligned
+    struct FileLayout
+    {
+        std::size_t classOf, table, finalBits, accel, size;
+
+        FileLayout(std::size_t stateCount, unsigned shift)
+        {
+            classOf = sizeof(FileHeader);
+            table = classOf + 256;
+            finalBits = table + (((stateCount << shift) * sizeof(CompiledDFA::StateId) + 7) & ~std::size_t{7});
+            accel = finalBits + (stateCount + 63) / 64 * sizeof(std::uint64_t);
+            size = accel + stateCount * ACCEL_BYTES;
+        }
+    };
+
+    std::uint64_t checksumOf(const char* data, std::size_t size)
+    {
+        std::uint64_t h {0x9E3779B97F4A7C15ULL ^ size};
+        std::size_t i {0};
+        for (; i + 8 <= size; i += 8)
+        {
+            std::uint64_t w;
+            std::memcpy(&w, data + i, 8);
+            h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 32;
+        }
+        for (; i < size; ++i)
+            h = (h ^ static_cast<unsigned char>(data[i])) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        return h ^ (h >> 33);
+    }
+}
+
+bool CompiledDFA::canCompile(const FiniteAutomaton& fa)
+{
+    if (!fa.isDeterministic())
+        return false;
+    for (std::size_t s = 0; s < fa.stateCount(); ++s)
+        for (auto t = fa.transitionsBegin(s); t != fa.transitionsEnd(s); ++t)
+            if (t->symbol == SymbolTable::EPSILON)
+                return false; // epsilon moves need the NFA path
+    return true;
+}
+
+CompiledDFA::CompiledDFA(const FiniteAutomaton& fa)
+{
+    if (!canCompile(fa))
+        throw std::invalid_argument("CompiledDFA: automaton is not deterministic");
+
+    // dense ids: 0 is dead, state index i is id i + 1
+    const std::size_t count {fa.stateCount() + 1};
+    struct Edge { unsigned char byte; StateId to; };
+    std::vector<std::uint32_t> offsets(count + 1, 0);
+    std::vector<Edge> edges {};
+    for (std::size_t s = 0; s < fa.stateCount(); ++s)
+    {
+        for (auto t = fa.transitionsBegin(s); t != fa.transitionsEnd(s); ++t)
+        {
+            // multi-character symbols can never be matched byte by byte
+            const Symbol& input {fa.symbols().name(t->symbol)};
+            if (input.size() == 1)
+                edges.push_back({static_cast<unsigned char>(input[0]), t->to + 1});
+        }
+        offsets[s + 2] = static_cast<std::uint32_t>(edges.size());
+    }
+    auto owned = std::make_shared<OwnedTables>();
+    std::vector<std::uint64_t>& finalBits {owned->finalBits};
+    finalBits.assign((count + 63) / 64, 0);
+    for (std::size_t s = 0; s < fa.stateCount(); ++s)
+        if (fa.isFinal(s))
+            finalBits[(s + 1) / 64] |= std::uint64_t{1} << ((s + 1) % 64);
+
+    // states that can never reach a final state behave like DEAD; pointing
+    // their incoming edges at row 0 lets callers stop as soon as it is reached
+    std::vector<std::vector<StateId>> predecessors(count);
+    for (StateId q = 1; q < count; ++q)
+        for (std::uint32_t e = offsets[q]; e < offsets[q + 1]; ++e)
+            predecessors[edges[e].to].push_back(q);
+    std::vector<bool> live(count, false);
+    std::vector<StateId> stack {};
+    for (StateId q = 1; q < count; ++q)
+        if ((finalBits[q / 64] >> (q % 64)) & 1U)
+        {
+            live[q] = true;
+            stack.push_back(q);
+        }
+    while (!stack.empty())
+    {
+        StateId q {stack.back()};
+        stack.pop_back();
+        for (StateId p : predecessors[q])
+            if (!live[p])
+            {
+                live[p] = true;
+                stack.push_back(p);
+            }
+    }
+    for (auto& e : edges)
+        if (!live[e.to])
+            e.to = DEAD;
+
+    // byte classes by refinement: every row splits off, from each class, the
+    // bytes that row sends to one target, unless they make up the whole class
+    m_classOf.fill(0);
+    m_classCount = 1;
+    std::array<std::uint32_t, 256> classSize {};
+    classSize[0] = 256;
+    std::vector<Edge> row {};
+    for (StateId q = 1; q < count; ++q)
+    {
+        if (!live[q])
+            continue;
+        row.clear();
+        for (std::uint32_t e = offsets[q]; e < offsets[q + 1]; ++e)
+            if (edges[e].to != DEAD)
+                row.push_back(edges[e]);
+        auto groupKey = [&](const Edge& e) { return (std::uint64_t{m_classOf[e.byte]} << 32) | e.to; };
+        std::sort(row.begin(), row.end(), [&](const Edge& a, const Edge& b) { return groupKey(a) < groupKey(b); });
+        for (std::size_t i = 0, j = 0; i < row.size(); i = j)
+        {
+            while (j < row.size() && groupKey(row[j]) == groupKey(row[i]))
+                ++j;
+            const std::uint8_t old {m_classOf[row[i].byte]};
+            if (j - i == classSize[old])
+                continue;
+            const auto fresh {static_cast<std::uint8_t>(m_classCount++)};
+            for (std::size_t k = i; k < j; ++k)
+                m_classOf[row[k].byte] = fresh;
+            classSize[old] -= static_cast<std::uint32_t>(j - i);
+            classSize[fresh] = static_cast<std::uint32_t>(j - i);
+        }
+    }
+
+    while ((std::size_t{1} << m_shift) < m_classCount)
+        ++m_shift;
+    // entries are premultiplied row offsets and must fit a StateId
+    if (count > (std::numeric_limits<StateId>::max() >> m_shift))
+        throw std::length_error("CompiledDFA: " + std::to_string(count) + " states with "
+                                + std::to_string(m_classCount) + " byte classes do not fit 32-bit row offsets");
+    std::vector<StateId>& table {owned->table};
+    table.assign(count << m_shift, DEAD);
+    for (StateId q = 1; q < count; ++q)
+        for (std::uint32_t e = offsets[q]; e < offsets[q + 1]; ++e)
+            if (live[q])
+                table[(q << m_shift) + m_classOf[edges[e].byte]] = edges[e].to << m_shift;
+
+    m_start = live[fa.initialIndex() + 1] ? (fa.initialIndex() + 1) << m_shift : DEAD;
+    m_stateCount = count;
+    m_table = table.data();
+    m_finalBits = finalBits.data();
+    m_storage = std::move(owned);
+    analyzeAcceleration();
+}
+
+std::vector<std::uint64_t> CompiledDFA::profile(const std::vector<std::string_view>& corpus) const
+{
+    std::vector<std::uint64_t> visits(m_stateCount, 0);
+    for (std::string_view input : corpus)
+    {
+        StateId s {m_start};
+        ++visits[s >> m_shift];
+        for (unsigned char c : input)
+        {
+            s = next(s, c);
+            if (s == DEAD)
+                break;
+            ++visits[s >> m_shift];
+        }
+    }
+    return visits;
+}
+
+CompiledDFA CompiledDFA::reordered(const std::vector<std::uint64_t>& visits) const
+{
+    if (!visits.empty() && visits.size() != m_stateCount)
+        throw std::invalid_argument("CompiledDFA: one visit count per state expected");
+    const std::size_t width {std::size_t{1} << m_shift};
+    auto hotness = [&](std::size_t q) { return visits.empty() ? 0 : visits[q]; };
+
+    // seeds: every state, hottest first, ties in depth-first order from the start
+    std::vector<std::uint32_t> dfsOrder {};
+    std::vector<bool> seen(m_stateCount, false);
+    seen[0] = true;
+    std::vector<std::uint32_t> stack {static_cast<std::uint32_t>(indexOf(m_start))};
+    while (!stack.empty())
+    {
+        const std::uint32_t q {stack.back()};
+        stack.pop_back();
+        if (seen[q])
+            continue;
+        seen[q] = true;
+        dfsOrder.push_back(q);
+        for (std::size_t c = width; c-- > 0;)
+        {
+            const auto t {static_cast<std::uint32_t>(indexOf(m_table[rowOf(q) + c]))};
+            if (!seen[t])
+                stack.push_back(t);
+        }
+    }
+    for (std::uint32_t q = 1; q < m_stateCount; ++q)
+        if (!seen[q])
+            dfsOrder.push_back(q); // unreachable from the start, kept for loaded files
+    std::stable_sort(dfsOrder.begin(), dfsOrder.end(),
+                     [&](std::uint32_t a, std::uint32_t b) { return hotness(a) > hotness(b); });
+
+    // chains: after a state, its hottest successor not placed yet
+    std::vector<std::uint32_t> newIndex(m_stateCount, 0);
+    std::vector<bool> placed(m_stateCount, false);
+    placed[0] = true;
+    std::uint32_t count {1};
+    for (std::uint32_t seed : dfsOrder)
+    {
+        for (std::uint32_t q = seed; !placed[q];)
+        {
+            placed[q] = true;
+            newIndex[q] = count++;
+            std::uint32_t best {0};
+            for (std::size_t c = 0; c < width; ++c)
+            {
+                const auto t {static_cast<std::uint32_t>(indexOf(m_table[rowOf(q) + c]))};
+                if (!placed[t] && (best == 0 || hotness(t) > hotness(best)))
+                    best = t;
+            }
+            q = best;
+        }
+    }
+
+    auto owned = std::make_shared<OwnedTables>();
+    owned->table.assign(m_stateCount << m_shift, DEAD);
+    owned->finalBits.assign((m_stateCount + 63) / 64, 0);
+    for (std::size_t q = 1; q < m_stateCount; ++q)
+    {
+        const std::size_t to {newIndex[q]};
+        for (std::size_t c = 0; c < width; ++c)
+            owned->table[(to << m_shift) + c] = rowOf(newIndex[indexOf(m_table[rowOf(q) + c])]);
+        if (isFinal(rowOf(q)))
+            owned->finalBits[to / 64] |= std::uint64_t{1} << (to % 64);
+    }
+
+    CompiledDFA dfa {*this};
+    dfa.m_start = rowOf(newIndex[indexOf(m_start)]);
+    dfa.m_table = owned->table.data();
+    dfa.m_finalBits = owned->finalBits.data();
+    dfa.m_storage = std::move(owned);
+    dfa.analyzeAcceleration();
+    return dfa;
+}
+
+void CompiledDFA::analyzeAcceleration()
+{
+    auto accel = std::make_shared<std::vector<Accel>>(m_stateCount);
+    for (std::size_t q = 0; q < m_stateCount; ++q)
+    {
+        const StateId row {rowOf(q)};
+        unsigned char loops[3], leaves[3];
+        unsigned loopCount {0}, leaveCount {0};
+        for (unsigned c = 0; c < 256; ++c)
+        {
+            if (next(row, static_cast<unsigned char>(c)) == row)
+            {
+                if (loopCount < 3)
+                    loops[loopCount] = static_cast<unsigned char>(c);
+                ++loopCount;
+            }
+            else
+            {
+                if (leaveCount < 3)
+                    leaves[leaveCount] = static_cast<unsigned char>(c);
+                ++leaveCount;
+            }
+        }
+        Accel& a {(*accel)[q]};
+        if (loopCount == 0)
+            continue;
+        if (leaveCount <= 3)
+        {
+            a.kind = Accel::UNTIL;
+            a.count = static_cast<std::uint8_t>(leaveCount);
+            std::copy(leaves, leaves + leaveCount, a.bytes);
+        }
+        else if (loopCount <= 3)
+        {
+            a.kind = Accel::WHILE;
+            a.count = static_cast<std::uint8_t>(loopCount);
+            std::copy(loops, loops + loopCount, a.bytes);
+        }
+    }
+    m_accel = accel->data();
+    m_accelStorage = std::move(accel);
+}
+
+std::size_t CompiledDFA::acceleratedCount() const
+{
+    std::size_t count {0};
+    for (std::size_t q = 1; q < m_stateCount; ++q)
+        count += m_accel[q].kind != Accel::NONE;
+    return count;
+}
+
+std::size_t CompiledDFA::skip(const Accel& a, const unsigned char* p, std::size_t i, std::size_t n)
+{
+    if (a.kind == Accel::UNTIL && a.count == 0)
+        return n;
+    if (a.kind == Accel::UNTIL && a.count == 1)
+    {
+        const void* hit {std::memchr(p + i, a.bytes[0], n - i)};
+        return hit ? static_cast<std::size_t>(static_cast<const unsigned char*>(hit) - p) : n;
+    }
+    // unused byte slots repeat the first byte
+    const unsigned char b0 {a.bytes[0]};
+    const unsigned char b1 {a.bytes[a.count > 1 ? 1 : 0]};
+    const unsigned char b2 {a.bytes[a.count > 2 ? 2 : 0]};
+    const bool stay {a.kind == Accel::WHILE};
+#if defined(__SSE2__)
+    const __m128i v0 {_mm_set1_epi8(static_cast<char>(b0))};
+    const __m128i v1 {_mm_set1_epi8(static_cast<char>(b1))};
+    const __m128i v2 {_mm_set1_epi8(static_cast<char>(b2))};
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))};
+        const __m128i in {_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, v0), _mm_cmpeq_epi8(v, v1)),
+                                       _mm_cmpeq_epi8(v, v2))};
+        unsigned mask {static_cast<unsigned>(_mm_movemask_epi8(in))};
+        if (stay)
+            mask = ~mask & 0xFFFFU;
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        const bool in {p[i] == b0 || p[i] == b1 || p[i] == b2};
+        if (in != stay)
+            return i;
+    }
+    return n;
+}
+
+void CompiledDFA::save(const std::string& path) const
+{
+    const FileLayout layout {m_stateCount, m_shift};
+    std::string bytes(layout.size, '\0');
+    std::memcpy(&bytes[layout.classOf], m_classOf.data(), 256);
+    std::memcpy(&bytes[layout.table], m_table, (m_stateCount << m_shift) * sizeof(StateId));
+    std::memcpy(&bytes[layout.finalBits], m_finalBits, (m_stateCount + 63) / 64 * sizeof(std::uint64_t));
+    std::memcpy(&bytes[layout.accel], m_accel, m_stateCount * sizeof(Accel));
+
+    FileHeader header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.stateCount = static_cast<std::uint32_t>(m_stateCount);
+    header.classCount = static_cast<std::uint32_t>(m_classCount);
+    header.shift = m_shift;
+    header.start = m_start;
+    header.checksum = checksumOf(bytes.data() + sizeof(FileHeader), bytes.size() - sizeof(FileHeader));
+    std::memcpy(&bytes[0], &header, sizeof(header));
+
+    std::ofstream out {path, std::ios::binary | std::ios::trunc};
+    if (!out.write(bytes.data(), static_cast<std::streamsize>(bytes.size())))
+        throw std::runtime_error("CompiledDFA: cannot write " + path);
+}
+
+CompiledDFA CompiledDFA::load(const std::string& path, bool verifyChecksum)
+{
+    auto file = std::make_shared<const MappedFile>(path);
+    FileHeader header {};
+    if (file->size() < sizeof(header))
+        throw std::runtime_error("CompiledDFA: " + path + " is too short");
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("CompiledDFA: " + path + " is not a compiled DFA");
+    if (header.version != FILE_VERSION)
+        throw std::runtime_error("CompiledDFA: " + path + " has format version " + std::to_string(header.version)
+                                 + ", expected " + std::to_string(FILE_VERSION));
+    if (header.byteOrder != BYTE_ORDER_MARK)
+        throw std::runtime_error("CompiledDFA: " + path + " was written with another byte order");
+    if (header.stateCount == 0 || header.shift > 8 || header.classCount == 0
+        || header.classCount > (std::size_t{1} << header.shift)
+        || header.stateCount > (std::numeric_limits<StateId>::max() >> header.shift)
+        || (header.start >> header.shift) >= header.stateCount || (header.start & ((1U << header.shift) - 1)) != 0
+        || FileLayout(header.stateCount, header.shift).size != file->size())
+        throw std::runtime_error("CompiledDFA: " + path + " has an inconsistent header");
+    const FileLayout layout {header.stateCount, header.shift};
+    if (verifyChecksum)
+    {
+        // a checksum only catches accidents; every byte class must be in range and
+        // every entry a row offset inside the table, or matches() would read past the mapping
+        const auto* classOf {reinterpret_cast<const std::uint8_t*>(file->data() + layout.classOf)};
+        for (std::size_t c = 0; c < 256; ++c)
+            if (classOf[c] >= header.classCount)
+                throw std::runtime_error("CompiledDFA: byte class " + std::to_string(classOf[c]) + " of byte "
+                                         + std::to_string(c) + " in " + path + " is out of range");
+        const StateId rowMask {(StateId{1} << header.shift) - 1};
+        const StateId rows {static_cast<StateId>(header.stateCount) << header.shift};
+        const char* table {file->data() + layout.table};
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            StateId entry;
+            std::memcpy(&entry, table + i * sizeof(StateId), sizeof(entry));
+            if (entry >= rows || (entry & rowMask) != 0)
+                throw std::runtime_error("CompiledDFA: table entry " + std::to_string(i) + " of " + path
+                                         + " is not a row offset");
+        }
+        const auto* accel {reinterpret_cast<const Accel*>(file->data() + layout.accel)};
+        for (std::size_t q = 0; q < header.stateCount; ++q)
+            if (accel[q].kind > Accel::WHILE || accel[q].count > 3)
+                throw std::runtime_error("CompiledDFA: acceleration record " + std::to_string(q) + " of " + path
+                                         + " is invalid");
+        if (checksumOf(file->data() + sizeof(header), file->size() - sizeof(header)) != header.checksum)
+            throw std::runtime_error("CompiledDFA: checksum mismatch in " + path);
+    }
+
+    CompiledDFA dfa {};
+    std::memcpy(dfa.m_classOf.data(), file->data() + layout.classOf, 256);
+    dfa.m_table = reinterpret_cast<const StateId*>(file->data() + layout.table);
+    dfa.m_finalBits = reinterpret_cast<const std::uint64_t*>(file->data() + layout.finalBits);
+    dfa.m_stateCount = header.stateCount;
+    dfa.m_classCount = header.classCount;
+    dfa.m_shift = header.shift;
+    dfa.m_start = header.start;
+    // the records were analyzed by save(), so loading reads no page it does not need
+    dfa.m_accel = reinterpret_cast<const Accel*>(file->data() + layout.accel);
+    dfa.m_storage = std::move(file);
+    return dfa;
+}
+
+CompiledDFA::StateId CompiledDFA::advance(StateId s, std::string_view chunk) const
+{
+    const StateId* table {m_table};
+    const std::uint8_t* classOf {m_classOf.data()};
+    const auto* p {reinterpret_cast<const unsigned char*>(chunk.data())};
+    const std::size_t n {chunk.size()};
+    for (std::size_t i = 0; i < n && s != DEAD;)
+    {
+        const StateId t {table[s + classOf[p[i++]]]};
+        if (t == s && m_accel[s >> m_shift].kind != Accel::NONE)
+            i = skip(m_accel[s >> m_shift], p, i, n);
+        s = t;
+    }
+    return s;
+}
+
+bool CompiledDFA::matches(std::string_view input) const
+{
+    const StateId* table {m_table};
+    StateId s {m_start};
+    const std::uint8_t* classOf {m_classOf.data()};
+    const auto* p {reinterpret_cast<const unsigned char*>(input.data())};
+    const std::size_t n {input.size()};
+    for (std::size_t i = 0; i < n;)
+    {
+        const StateId t {table[s + classOf[p[i++]]]};
+        // a self-loop: skip straight to the next byte that can leave it
+        if (t == s && m_accel[s >> m_shift].kind != Accel::NONE)
+            i = skip(m_accel[s >> m_shift], p, i, n);
+        s = t;
+    }
+    return isFinal(s);
+}
+
+template <unsigned W>
+void CompiledDFA::matchGroup(const std::string_view* inputs, std::uint8_t* out) const
+{
+    const StateId* table {m_table};
+    const std::uint8_t* classOf {m_classOf.data()};
+    StateId s[W];
+    std::size_t common {inputs[0].size()};
+    for (unsigned i = 0; i < W; ++i)
+    {
+        s[i] = m_start;
+        common = std::min(common, inputs[i].size());
+    }
+    for (std::size_t pos = 0; pos < common; ++pos)
+        for (unsigned i = 0; i < W; ++i)
+            s[i] = table[s[i] + classOf[static_cast<unsigned char>(inputs[i][pos])]];
+    for (unsigned i = 0; i < W; ++i)
+    {
+        for (std::size_t pos = common; pos < inputs[i].size(); ++pos)
+            s[i] = table[s[i] + classOf[static_cast<unsigned char>(inputs[i][pos])]];
+        out[i] = isFinal(s[i]);
+    }
+}
+
+void CompiledDFA::matchMany(const std::string_view* inputs, std::size_t count, std::uint8_t* out, unsigned interleave) const
+{
+    std::size_t i {0};
+    if (interleave >= 8)
+        for (; i + 8 <= count; i += 8)
+            matchGroup<8>(inputs + i, out + i);
+    if (interleave >= 4)
+        for (; i + 4 <= count; i += 4)
+            matchGroup<4>(inputs + i, out + i);
+    if (interleave >= 2)
+        for (; i + 2 <= count; i += 2)
+            matchGroup<2>(inputs + i, out + i);
+    for (; i < count; ++i)
+        out[i] = matches(inputs[i]);
+}
@@ -0,0 +1,111 @@
+#ifndef COMPILED_DFA_H
+#define COMPILED_DFA_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class FiniteAutomaton;
+
+// Flat, integer-indexed form of a deterministic FiniteAutomaton.
+// Bytes that no transition tells apart share an equivalence class, and a
+// 256-entry map sends each byte to its class. Row 0 is the dead state; every
+// row has one entry per class, padded to a power of two, and entries are
+// stored premultiplied by the row width so a step is two dependent loads.
+// States that cannot reach a final state are folded into the dead state.
+//
+// The tables are read through plain pointers into shared, immutable storage:
+// either vectors built by the constructor or a file written by save() and
+// memory-mapped by load(), which is then used in place. Copies share it.
+//
+// States that loop on all but at most three bytes, or on at most three bytes
+// and leave on every other, are accelerated: once such a state steps to itself,
+// matches() and advance() scan ahead for the next byte that leaves it with
+// memchr or SSE2 compares instead of stepping byte by byte.
+class CompiledDFA
+{
+public:
+    using StateId = std::uint32_t;
+    static constexpr StateId DEAD {0};
+
+    // throws std::invalid_argument if fa is not deterministic or has epsilon moves, and
+    // std::length_error if its row offsets overflow 32 bits (about 2^24 states at 256 classes)
+    explicit CompiledDFA(const FiniteAutomaton& fa);
+    CompiledDFA() = default;
+
+    bool matches(std::string_view input) const;
+    // out[i] = matches(inputs[i]); `interleave` inputs (1, 2, 4 or 8) are stepped
+    // together so their independent table loads overlap
+    void matchMany(const std::string_view* inputs, std::size_t count, std::uint8_t* out, unsigned interleave = 1) const;
+    static bool canCompile(const FiniteAutomaton& fa);
+    // runs `chunk` from state s, stopping early once DEAD is reached
+    StateId advance(StateId s, std::string_view chunk) const;
+
+    // visits per state index while matching every corpus input, for reordered()
+    std::vector<std::uint64_t> profile(const std::vector<std::string_view>& corpus) const;
+    // copy with the rows renumbered for cache locality: the hottest state first,
+    // then each placed state's hottest unplaced successor, chain by chain. With
+    // no visit counts the order is depth-first from the start state. Row 0 stays
+    // dead; the layout is the table itself, so save() keeps it.
+    CompiledDFA reordered(const std::vector<std::uint64_t>& visits = {}) const;
+
+    // binary format: a 64-byte header (magic, version, byte order, sizes and a
+    // checksum of the rest), then the class map, the table, the final bitmap and
+    // one acceleration record per state
+    static constexpr std::uint32_t FILE_VERSION {2};
+    void save(const std::string& path) const;
+    // maps the file and uses its tables in place; throws std::runtime_error if the
+    // header does not match this build or, when verifyChecksum is set, a byte
+    // class is out of range, a table entry is not a row offset or the checksum
+    // does not match. An unverified load reads only the header and trusts the rest.
+    static CompiledDFA load(const std::string& path, bool verifyChecksum = true);
+
+    //getters: states are addressed by row offset, index = row >> shift
+    std::size_t stateCount() const { return m_stateCount; }
+    StateId startState() const { return m_start; }
+    StateId rowOf(std::size_t index) const { return static_cast<StateId>(index << m_shift); }
+    std::size_t indexOf(StateId row) const { return row >> m_shift; }
+    bool isFinal(StateId row) const { return (m_finalBits[(row >> m_shift) / 64] >> ((row >> m_shift) % 64)) & 1U; }
+    StateId next(StateId row, unsigned char c) const { return m_table[row + m_classOf[c]]; }
+    std::size_t classCount() const { return m_classCount; }
+    std::uint8_t classOf(unsigned char c) const { return m_classOf[c]; }
+    std::size_t tableBytes() const { return (m_stateCount << m_shift) * sizeof(StateId) + sizeof(m_classOf); }
+    bool isAccelerated(StateId row) const { return m_accel[row >> m_shift].kind != Accel::NONE; }
+    // accelerated live states, the dead state not counted
+    std::size_t acceleratedCount() const;
+
+private:
+    // how to skip a self-loop: UNTIL the next byte in `bytes`, or WHILE bytes
+    // are in it; UNTIL with count 0 never leaves the state
+    struct Accel
+    {
+        enum Kind : std::uint8_t { NONE, UNTIL, WHILE };
+        Kind kind {NONE};
+        std::uint8_t count {0};
+        unsigned char bytes[3] {};
+    };
+    static_assert(sizeof(Accel) == 5, "acceleration records are part of the file format");
+    void analyzeAcceleration();
+    // index of the first byte in [i, n) that leaves the state described by a
+    static std::size_t skip(const Accel& a, const unsigned char* p, std::size_t i, std::size_t n);
+
+    template <unsigned W>
+    void matchGroup(const std::string_view* inputs, std::uint8_t* out) const;
+
+    const StateId* m_table {nullptr};     // stateCount << shift, values are row offsets
+    const std::uint64_t* m_finalBits {nullptr};
+    std::shared_ptr<const void> m_storage {}; // owns m_table and m_finalBits
+    const Accel* m_accel {nullptr};        // per state index, in m_accelStorage or a loaded file
+    std::shared_ptr<const std::vector<Accel>> m_accelStorage {};
+    std::array<std::uint8_t, 256> m_classOf {};
+    std::size_t m_stateCount {0};
+    std::size_t m_classCount {1};
+    unsigned m_shift {0};                 // log2 of the row width
+    StateId m_start {DEAD};
+};
+
+#endif
@@ -0,0 +1,269 @@
+#include "denseNFA.h"
+#include "finiteAutomaton.h"
+#include <algorithm>
+#include <cstdint>
+
+DenseNFA::DenseNFA(const FiniteAutomaton& fa)
+{
+    states = fa.stateCount();
+    symbolIds = fa.inputSymbols();
+    for (SymbolId a : symbolIds)
+        symbols.push_back(fa.symbols().name(a));
+    std::vector<std::int32_t> column(fa.symbols().size(), -1);
+    for (std::size_t a = 0; a < symbolIds.size(); ++a)
+        column[symbolIds[a]] = static_cast<std::int32_t>(a);
+
+    const std::size_t n {stateCount()};
+    const std::size_t k {symbolCount()};
+    words = (n + 63) / 64;
+
+    // direct edges per state as (symbol column, target), sorted; epsilon apart
+    std::vector<std::vector<std::uint32_t>> epsilon(n);
+    std::vector<std::uint32_t> edgeRows(n + 1, 0);
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> edges {};
+    for (std::size_t from = 0; from < n; ++from)
+    {
+        const std::size_t first {edges.size()};
+        for (auto t = fa.transitionsBegin(from); t != fa.transitionsEnd(from); ++t)
+        {
+            if (t->symbol == SymbolTable::EPSILON)
+                epsilon[from].push_back(t->to);
+            else
+                edges.push_back({static_cast<std::uint32_t>(column[t->symbol]), t->to});
+        }
+        std::sort(edges.begin() + static_cast<std::ptrdiff_t>(first), edges.end());
+        edgeRows[from + 1] = static_cast<std::uint32_t>(edges.size());
+    }
+
+    // epsilon closure of every state, once, as CSR
+    std::vector<std::uint32_t> closureOffsets(n + 1, 0);
+    std::vector<std::uint32_t> closure {};
+    std::vector<std::size_t> stamp(n, SIZE_MAX);
+    std::vector<std::uint32_t> stack {};
+    for (std::uint32_t s = 0; s < n; ++s)
+    {
+        stamp[s] = s;
+        closure.push_back(s);
+        stack.assign(1, s);
+        while (!stack.empty())
+        {
+            std::uint32_t q {stack.back()};
+            stack.pop_back();
+            for (std::uint32_t r : epsilon[q])
+                if (stamp[r] != s)
+                {
+                    stamp[r] = s;
+                    closure.push_back(r);
+                    stack.push_back(r);
+                }
+        }
+        closureOffsets[s + 1] = static_cast<std::uint32_t>(closure.size());
+    }
+
+    start.assign(words, 0);
+    const std::uint32_t initial {fa.initialIndex()};
+    for (std::uint32_t i = closureOffsets[initial]; i < closureOffsets[initial + 1]; ++i)
+        start[closure[i] / 64] |= std::uint64_t{1} << (closure[i] % 64);
+    finals.assign(words, 0);
+    for (std::uint32_t s = 0; s < n; ++s)
+        if (fa.isFinal(s))
+            finals[s / 64] |= std::uint64_t{1} << (s % 64);
+
+    // folded successors: union of the closures of the direct targets, deduplicated,
+    // one entry per (state, symbol) with edges
+    std::fill(stamp.begin(), stamp.end(), SIZE_MAX);
+    rows.assign(n + 1, 0);
+    offsets.assign(1, 0);
+    std::size_t entry {0};
+    for (std::size_t from = 0; from < n; ++from)
+    {
+        for (std::uint32_t e = edgeRows[from]; e < edgeRows[from + 1]; ++entry)
+        {
+            const std::uint32_t symbol {edges[e].first};
+            for (; e < edgeRows[from + 1] && edges[e].first == symbol; ++e)
+            {
+                const std::uint32_t to {edges[e].second};
+                for (std::uint32_t c = closureOffsets[to]; c < closureOffsets[to + 1]; ++c)
+                    if (stamp[closure[c]] != entry)
+                    {
+                        stamp[closure[c]] = entry;
+                        targets.push_back(closure[c]);
+                    }
+            }
+            entrySymbol.push_back(symbol);
+            offsets.push_back(static_cast<std::uint32_t>(targets.size()));
+        }
+        rows[from + 1] = static_cast<std::uint32_t>(entrySymbol.size());
+    }
+
+    // a direct index costs at most four slots per entry or state here
+    if (k * n <= 4 * (entrySymbol.size() + n))
+    {
+        direct.assign(k * n, NO_ENTRY);
+        for (std::size_t q = 0; q < n; ++q)
+            for (std::uint32_t e = rows[q]; e < rows[q + 1]; ++e)
+                direct[q * k + entrySymbol[e]] = e;
+    }
+}
+
+bool DenseNFA::move(SubsetView from, std::size_t symbol, std::uint64_t* out) const
+{
+    bool any {false};
+    for (std::size_t w = from.lo; w < from.hi; ++w)
+        for (std::uint64_t bits = from.bits[w - from.lo]; bits; bits &= bits - 1)
+        {
+            const std::size_t e {entryOf(symbol, w * 64 + __builtin_ctzll(bits))};
+            if (e == NONE)
+                continue;
+            for (std::uint32_t i = offsets[e]; i < offsets[e + 1]; ++i)
+                out[targets[i] / 64] |= std::uint64_t{1} << (targets[i] % 64);
+            any = true;
+        }
+    return any;
+}
+
+bool DenseNFA::intersectsFinals(SubsetView set) const
+{
+    for (std::size_t w = set.lo; w < set.hi; ++w)
+        if (set.bits[w - set.lo] & finals[w])
+            return true;
+    return false;
+}
+
+std::vector<std::uint64_t> DenseNFA::liveStates() const
+{
+    const std::size_t n {stateCount()};
+    std::vector<std::vector<std::uint32_t>> predecessors(n);
+    for (std::uint32_t s = 0; s < n; ++s)
+        for (std::uint32_t i = offsets[rows[s]]; i < offsets[rows[s + 1]]; ++i)
+            predecessors[targets[i]].push_back(s);
+
+    std::vector<std::uint64_t> live {finals};
+    std::vector<std::uint32_t> stack {};
+    for (std::uint32_t s = 0; s < n; ++s)
+        if ((finals[s / 64] >> (s % 64)) & 1U)
+            stack.push_back(s);
+    while (!stack.empty())
+    {
+        std::uint32_t q {stack.back()};
+        stack.pop_back();
+        for (std::uint32_t p : predecessors[q])
+            if (!((live[p / 64] >> (p % 64)) & 1U))
+            {
+                live[p / 64] |= std::uint64_t{1} << (p % 64);
+                stack.push_back(p);
+            }
+    }
+    return live;
+}
+
+SubsetTable::SubsetTable(std::size_t words)
+    : m_words {words}
+    , m_slots(1024, 0)
+{
+}
+
+SubsetTable::Range SubsetTable::rangeOf(const std::uint64_t* set) const
+{
+    Range r {0, 0, 0};
+    std::size_t w {0};
+    while (w < m_words && !set[w])
+        ++w;
+    r.lo = r.hi = static_cast<std::uint32_t>(w);
+    for (; w < m_words; ++w)
+        if (set[w])
+            r.hi = static_cast<std::uint32_t>(w + 1);
+    return r;
+}
+
+std::size_t SubsetTable::hashOf(const std::uint64_t* bits, Range r)
+{
+    std::uint64_t h {0x9E3779B97F4A7C15ULL ^ r.lo};
+    for (std::size_t w = 0; w < r.hi - r.lo; ++w)
+        h = (h ^ bits[w]) * 0xFF51AFD7ED558CCDULL;
+    // the multiply only carries upward, so fold the high bits back down
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    return static_cast<std::size_t>(h ^ (h >> 33));
+}
+
+// slot holding `set`, or the empty slot where it would go
+std::size_t SubsetTable::slotOf(const std::uint64_t* set, Range r) const
+{
+    const std::size_t mask {m_slots.size() - 1};
+    std::size_t i {hashOf(set + r.lo, r) & mask};
+    for (; m_slots[i]; i = (i + 1) & mask)
+    {
+        const Range& other {m_ranges[m_slots[i] - 1]};
+        if (other.lo == r.lo && other.hi == r.hi
+            && std::equal(set + r.lo, set + r.hi, m_pool.data() + other.offset))
+            break;
+    }
+    return i;
+}
+
+std::size_t SubsetTable::find(const std::uint64_t* set) const
+{
+    const std::uint32_t id {m_slots[slotOf(set, rangeOf(set))]};
+    return id ? id - 1 : NPOS;
+}
+
+std::size_t SubsetTable::insert(const std::uint64_t* set)
+{
+    Range r {rangeOf(set)};
+    const std::size_t slot {slotOf(set, r)};
+    if (m_slots[slot])
+        return m_slots[slot] - 1;
+    r.offset = m_pool.size();
+    m_pool.insert(m_pool.end(), set + r.lo, set + r.hi);
+    m_ranges.push_back(r);
+    m_slots[slot] = static_cast<std::uint32_t>(m_ranges.size());
+    if (m_ranges.size() * 2 > m_slots.size())
+        grow();
+    return m_ranges.size() - 1;
+}
+
+void SubsetTable::grow()
+{
+    std::vector<std::uint32_t> bigger(m_slots.size() * 2, 0);
+    const std::size_t mask {bigger.size() - 1};
+    for (std::size_t id = 0; id < m_ranges.size(); ++id)
+    {
+        std::size_t i {hashOf(m_pool.data() + m_ranges[id].offset, m_ranges[id]) & mask};
+        while (bigger[i])
+            i = (i + 1) & mask;
+        bigger[i] = static_cast<std::uint32_t>(id + 1);
+    }
+    m_slots.swap(bigger);
+}
+
+std::size_t SubsetTable::bytes() const
+{
+    return m_pool.capacity() * sizeof(std::uint64_t) + m_ranges.capacity() * sizeof(Range)
+         + m_slots.capacity() * sizeof(std::uint32_t);
+}
+
+namespace
+{
+    // capacity of a vector after `added` more elements, growing by doubling
+    std::size_t grownCapacity(std::size_t size, std::size_t capacity, std::size_t added)
+    {
+        return size + added <= capacity ? capacity : std::max(2 * capacity, size + added);
+    }
+}
+
+std::size_t SubsetTable::bytesAfterInsert(std::size_t setWords) const
+{
+    // grow() doubles the slots once more than half are taken, keeping the old array until it is done
+    const bool rehash {(m_ranges.size() + 1) * 2 > m_slots.size()};
+    return grownCapacity(m_pool.size(), m_pool.capacity(), setWords) * sizeof(std::uint64_t)
+         + grownCapacity(m_ranges.size(), m_ranges.capacity(), 1) * sizeof(Range)
+         + (rehash ? 3 : 1) * m_slots.capacity() * sizeof(std::uint32_t);
+}
+
+void SubsetTable::clear()
+{
+    std::vector<Range> {}.swap(m_ranges);
+    std::vector<std::uint64_t> {}.swap(m_pool);
+    std::vector<std::uint32_t>(1024, 0).swap(m_slots);
+}
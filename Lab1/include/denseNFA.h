@@ -0,0 +1,128 @@
+#ifndef DENSE_NFA_H
+#define DENSE_NFA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class FiniteAutomaton;
+
+// A stored subset: bits[0] is word `lo` of the full bitset, words outside [lo, hi) are zero.
+struct SubsetView
+{
+    const std::uint64_t* bits;
+    std::uint32_t lo;
+    std::uint32_t hi;
+};
+
+// Integer-indexed view of a FiniteAutomaton shared by the compiled forms.
+// States are the automaton's own state indices, symbols are its
+// non-epsilon inputs sorted by name, and epsilon closures are computed once
+// per state and folded into the successor lists. The lists are stored
+// state-major in CSR form: state q's row holds one (symbol, list) entry per
+// symbol it has successors on, sorted by symbol, so memory tracks the number
+// of transitions rather than symbols * states. When symbols * states is within
+// a small factor of that anyway (small alphabets), a direct (state, symbol) ->
+// entry index spares the lookups their bisection.
+struct DenseNFA
+{
+    explicit DenseNFA(const FiniteAutomaton& fa);
+
+    std::size_t stateCount() const { return states; }
+    std::size_t symbolCount() const { return symbols.size(); }
+
+    // successors of (symbol, state), epsilon closure included; an empty range
+    // if there are none
+    const std::uint32_t* succBegin(std::size_t symbol, std::size_t state) const
+    {
+        const std::size_t e {entryOf(symbol, state)};
+        return targets.data() + (e == NONE ? 0 : offsets[e]);
+    }
+    const std::uint32_t* succEnd(std::size_t symbol, std::size_t state) const
+    {
+        const std::size_t e {entryOf(symbol, state)};
+        return targets.data() + (e == NONE ? 0 : offsets[e + 1]);
+    }
+
+    // out |= successors on `symbol` of every state in `from`; false if there are none
+    bool move(SubsetView from, std::size_t symbol, std::uint64_t* out) const;
+    bool intersectsFinals(SubsetView set) const;
+    // bitset of the states from which some final state is reachable
+    std::vector<std::uint64_t> liveStates() const;
+
+    std::size_t states {0};
+    std::vector<std::string> symbols {};
+    std::vector<std::uint32_t> symbolIds {};   // symbols[a] as a symbol-table id
+    std::size_t words {0};                     // 64-bit words per state set
+    std::vector<std::uint64_t> start {};       // epsilon closure of the initial state
+    std::vector<std::uint64_t> finals {};
+    std::vector<std::uint32_t> rows {};        // state q's entries are [rows[q], rows[q + 1])
+    std::vector<std::uint32_t> entrySymbol {}; // per entry, increasing within a row
+    std::vector<std::uint32_t> offsets {};     // per entry + 1: its successors in targets
+    std::vector<std::uint32_t> targets {};
+    std::vector<std::uint32_t> direct {};      // state * symbolCount + symbol -> entry, or empty
+
+private:
+    static constexpr std::size_t NONE {static_cast<std::size_t>(-1)};
+    static constexpr std::uint32_t NO_ENTRY {~std::uint32_t{0}};
+
+    std::size_t entryOf(std::size_t symbol, std::size_t state) const
+    {
+        if (!direct.empty())
+        {
+            const std::uint32_t e {direct[state * symbolCount() + symbol]};
+            return e == NO_ENTRY ? NONE : e;
+        }
+        const std::uint32_t* first {entrySymbol.data() + rows[state]};
+        const std::uint32_t* last {entrySymbol.data() + rows[state + 1]};
+        const std::uint32_t* it {std::lower_bound(first, last, static_cast<std::uint32_t>(symbol))};
+        return it != last && *it == symbol ? static_cast<std::size_t>(it - entrySymbol.data()) : NONE;
+    }
+};
+
+// Interns state subsets of a DenseNFA as dense ids 0, 1, 2, ... Only the words
+// between the first and last non-zero one are kept, back to back in one pool,
+// so sparse subsets of a large NFA are cheap to store, hash and compare.
+// Lookup is open addressing with linear probing.
+class SubsetTable
+{
+public:
+    static constexpr std::size_t NPOS {static_cast<std::size_t>(-1)};
+
+    explicit SubsetTable(std::size_t words);
+
+    // `set` is a full-width bitset of `words` words
+    std::size_t find(const std::uint64_t* set) const;
+    std::size_t insert(const std::uint64_t* set);
+
+    SubsetView view(std::size_t id) const
+    {
+        const Range& r {m_ranges[id]};
+        return {m_pool.data() + r.offset, r.lo, r.hi};
+    }
+    std::size_t size() const { return m_ranges.size(); }
+    // memory held, by capacity
+    std::size_t bytes() const;
+    // bytes() once one more subset of up to `setWords` words is inserted, assuming
+    // vectors double when full; never less than the real figure
+    std::size_t bytesAfterInsert(std::size_t setWords) const;
+    // forgets every subset and frees their memory
+    void clear();
+
+private:
+    struct Range { std::uint32_t lo, hi; std::size_t offset; };
+
+    Range rangeOf(const std::uint64_t* set) const;
+    static std::size_t hashOf(const std::uint64_t* bits, Range r);
+    std::size_t slotOf(const std::uint64_t* set, Range r) const;
+    void grow();
+
+    std::size_t m_words {0};
+    std::vector<Range> m_ranges {};
+    std::vector<std::uint64_t> m_pool {};
+    std::vector<std::uint32_t> m_slots {};  // id + 1, 0 = empty
+};
+
+#endif
@@ -1,38 +1,439 @@
 #include "finiteAutomaton.h"
 #include "grammar.h"
+#include "compiledDFA.h"
+#include "packedDFA.h"
+#include "bitParallelNFA.h"
+#include "denseNFA.h"
+#include "nfaReduction.h"
+#include "languageInclusion.h"
+#include "lazyDFA.h"
+#include "threadPool.h"
+#include "matcherState.h"
+#include "searcher.h"
+#include "approximateMatcher.h"
+#include "mappedFile.h"
 #include <algorithm>
+#include <cmath>
+#include <unordered_map>
+namespace
+{
+    // copy of `base` with "Q0" .. "Q<count-1>" added; ids[i] is the id of "Qi"
+    std::shared_ptr<const SymbolTable> withStateNames(const SymbolTable& base, std::size_t count,
+                                                      std::vector<SymbolId>& ids)
+    {
+        auto table = std::make_shared<SymbolTable>(base);
+        ids.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+            ids[i] = table->intern("Q" + std::to_string(i));
+        return table;
+    }
+}
+
 FiniteAutomaton::FiniteAutomaton(std::set<Symbol> states, std::set<Symbol> alphabet,
                     std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> transitions,
                     Symbol initialState, std::set<Symbol> finalStates)
-                    : m_states {states}
-                    , m_alphabet {alphabet}
-                    , m_transitions {transitions}
-                    , m_initialState {initialState}
-                    , m_finalStates {finalStates}
     {
+        auto table = std::make_shared<SymbolTable>();
+        std::vector<SymbolId> stateIds {};
+        for (const auto& s : states)
+            stateIds.push_back(table->intern(s));
+        std::vector<SymbolId> alphabetIds {};
+        for (const auto& a : alphabet)
+            alphabetIds.push_back(table->intern(a));
+        std::vector<TransitionIds> transitionIds {};
+        for (const auto& [key, destinations] : transitions)
+        {
+            const SymbolId from {table->intern(key.first)};
+            const SymbolId input {table->intern(key.second)};
+            for (const auto& to : destinations)
+                transitionIds.push_back({from, input, table->intern(to)});
+        }
+        const SymbolId initial {table->intern(initialState)};
+        std::vector<SymbolId> finalIds {};
+        for (const auto& f : finalStates)
+            finalIds.push_back(table->intern(f));
 
+        m_symbols = std::move(table);
+        build(std::move(stateIds), std::move(alphabetIds), transitionIds, initial, finalIds);
+    }
+FiniteAutomaton::FiniteAutomaton(std::shared_ptr<const SymbolTable> symbols, std::vector<SymbolId> states,
+                    std::vector<SymbolId> alphabet, const std::vector<TransitionIds>& transitions,
+                    SymbolId initialState, const std::vector<SymbolId>& finalStates)
+                    : m_symbols {std::move(symbols)}
+    {
+        build(std::move(states), std::move(alphabet), transitions, initialState, finalStates);
     }
+const std::shared_ptr<const SymbolTable>& FiniteAutomaton::emptySymbols()
+{
+    static const std::shared_ptr<const SymbolTable> empty {std::make_shared<SymbolTable>()};
+    return empty;
+}
+void FiniteAutomaton::build(std::vector<SymbolId> states, std::vector<SymbolId> alphabet,
+                            const std::vector<TransitionIds>& transitions, SymbolId initialState,
+                            const std::vector<SymbolId>& finalStates)
+{
+    // every referenced state gets a dense index, in ascending id order;
+    // ids are dense too, so a mark per id replaces sorting the references
+    std::vector<std::uint32_t> indexOf(m_symbols->size(), 0);
+    indexOf[initialState] = 1;
+    for (SymbolId s : states)
+        indexOf[s] = 1;
+    for (SymbolId f : finalStates)
+        indexOf[f] = 1;
+    for (const auto& t : transitions)
+        indexOf[t.from] = indexOf[t.to] = 1;
+    states.clear();
+    for (SymbolId id = 0; id < indexOf.size(); ++id)
+        if (indexOf[id])
+            states.push_back(id);
+    m_stateIds = std::move(states);
+
+    for (std::uint32_t i = 0; i < m_stateIds.size(); ++i)
+        indexOf[m_stateIds[i]] = i;
+
+    m_initialState = initialState;
+    m_initialIndex = indexOf[initialState];
+    m_final.assign(m_stateIds.size(), 0);
+    for (SymbolId f : finalStates)
+        m_final[indexOf[f]] = 1;
+
+    const SymbolTable& names {*m_symbols};
+    std::sort(alphabet.begin(), alphabet.end(), [&](SymbolId a, SymbolId b) { return names.name(a) < names.name(b); });
+    alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+    m_alphabet = std::move(alphabet);
+
+    // CSR rows by source state (counting sort), then sort and deduplicate each row
+    m_transitionOffsets.assign(m_stateIds.size() + 1, 0);
+    for (const auto& t : transitions)
+        ++m_transitionOffsets[indexOf[t.from] + 1];
+    for (std::size_t i = 1; i < m_transitionOffsets.size(); ++i)
+        m_transitionOffsets[i] += m_transitionOffsets[i - 1];
+    m_transitions.resize(transitions.size());
+    {
+        std::vector<std::uint32_t> fill(m_transitionOffsets.begin(), m_transitionOffsets.end() - 1);
+        for (const auto& t : transitions)
+            m_transitions[fill[indexOf[t.from]]++] = {t.symbol, indexOf[t.to]};
+    }
+    auto byKey = [](const Transition& a, const Transition& b) { return a.symbol != b.symbol ? a.symbol < b.symbol : a.to < b.to; };
+    auto sameKey = [](const Transition& a, const Transition& b) { return a.symbol == b.symbol && a.to == b.to; };
+    std::size_t out {0};
+    for (std::size_t s = 0; s < m_stateIds.size(); ++s)
+    {
+        auto rowBegin = m_transitions.begin() + m_transitionOffsets[s];
+        auto rowEnd = m_transitions.begin() + m_transitionOffsets[s + 1];
+        std::sort(rowBegin, rowEnd, byKey);
+        m_transitionOffsets[s] = static_cast<std::uint32_t>(out);
+        for (auto it = rowBegin; it != rowEnd; ++it)
+            if (it == rowBegin || !sameKey(*it, *(it - 1)))
+                m_transitions[out++] = *it;
+    }
+    m_transitionOffsets.back() = static_cast<std::uint32_t>(out);
+    m_transitions.resize(out);
+
+    if (CompiledDFA::canCompile(*this))
+    {
+        try
+        {
+            m_dfa = std::make_shared<const CompiledDFA>(*this);
+            return;
+        }
+        catch (const std::length_error&)
+        {
+            // too many states for 32-bit row offsets: simulate it as an NFA instead
+        }
+    }
+    m_nfa = std::make_shared<const BitParallelNFA>(*this);
+}
+std::vector<SymbolId> FiniteAutomaton::inputSymbols() const
+{
+    std::vector<SymbolId> symbols {m_alphabet};
+    std::vector<bool> seen(m_symbols->size(), false);
+    for (SymbolId a : m_alphabet)
+        seen[a] = true;
+    seen[SymbolTable::EPSILON] = true;
+    for (const auto& t : m_transitions)
+        if (!seen[t.symbol])
+        {
+            seen[t.symbol] = true;
+            symbols.push_back(t.symbol);
+        }
+    symbols.erase(std::remove(symbols.begin(), symbols.end(), SymbolTable::EPSILON), symbols.end());
+    const SymbolTable& names {*m_symbols};
+    std::sort(symbols.begin(), symbols.end(), [&](SymbolId a, SymbolId b) { return names.name(a) < names.name(b); });
+    return symbols;
+}
+std::set<Symbol> FiniteAutomaton::states() const
+{
+    std::set<Symbol> names {};
+    for (SymbolId id : m_stateIds)
+        names.insert(m_symbols->name(id));
+    return names;
+}
+std::set<Symbol> FiniteAutomaton::alphabet() const
+{
+    std::set<Symbol> names {};
+    for (SymbolId id : m_alphabet)
+        names.insert(m_symbols->name(id));
+    return names;
+}
+std::set<Symbol> FiniteAutomaton::finalStates() const
+{
+    std::set<Symbol> names {};
+    for (std::size_t s = 0; s < m_stateIds.size(); ++s)
+        if (m_final[s])
+            names.insert(stateName(s));
+    return names;
+}
+std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> FiniteAutomaton::transitions() const
+{
+    std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> named {};
+    for (std::size_t s = 0; s < m_stateIds.size(); ++s)
+        for (auto t = transitionsBegin(s); t != transitionsEnd(s); ++t)
+            named[{stateName(s), m_symbols->name(t->symbol)}].insert(stateName(t->to));
+    return named;
+}
+FiniteAutomaton FiniteAutomaton::fromText(std::string_view text)
+{
+    auto table = std::make_shared<SymbolTable>();
+    std::vector<SymbolId> states {}, alphabet {}, finals {};
+    std::vector<TransitionIds> transitions {};
+    std::vector<bool> inAlphabet {};
+    bool haveAlphabet {false};
+    SymbolId initial {SymbolTable::NPOS};
+    constexpr std::string_view EPSILON_NAME {"ε"};
+
+    std::size_t lineNumber {0};
+    std::vector<std::string_view> tokens {};
+    for (std::size_t pos = 0; pos < text.size();)
+    {
+        std::size_t eol {text.find('\n', pos)};
+        if (eol == std::string_view::npos)
+            eol = text.size();
+        std::string_view line {text.substr(pos, eol - pos)};
+        pos = eol + 1;
+        ++lineNumber;
+
+        line = line.substr(0, line.find('#'));
+        tokens.clear();
+        for (std::size_t i = 0; i < line.size();)
+        {
+            while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+                ++i;
+            std::size_t j {i};
+            while (j < line.size() && line[j] != ' ' && line[j] != '\t' && line[j] != '\r')
+                ++j;
+            if (j > i)
+                tokens.push_back(line.substr(i, j - i));
+            i = j;
+        }
+        if (tokens.empty())
+            continue;
+
+        auto fail = [&](const std::string& what) {
+            return std::invalid_argument("FiniteAutomaton::fromText: line " + std::to_string(lineNumber) + ": " + what);
+        };
+        if (tokens[0][0] == '%')
+        {
+            const std::string_view directive {tokens[0]};
+            std::vector<SymbolId>* into {nullptr};
+            if (directive == "%states")
+                into = &states;
+            else if (directive == "%final")
+                into = &finals;
+            else if (directive == "%alphabet")
+            {
+                into = &alphabet;
+                haveAlphabet = true;
+            }
+            else if (directive == "%initial")
+            {
+                if (tokens.size() != 2)
+                    throw fail("%initial takes exactly one state");
+                initial = table->intern(tokens[1]);
+                continue;
+            }
+            else
+                throw fail("unknown directive " + std::string(directive));
+            for (std::size_t i = 1; i < tokens.size(); ++i)
+                into->push_back(table->intern(tokens[i]));
+            continue;
+        }
+        if (tokens.size() != 3)
+            throw fail("expected \"from symbol to\"");
+        const SymbolId symbol {tokens[1] == EPSILON_NAME ? SymbolTable::EPSILON : table->intern(tokens[1])};
+        transitions.push_back({table->intern(tokens[0]), symbol, table->intern(tokens[2])});
+        if (symbol >= inAlphabet.size())
+            inAlphabet.resize(table->size(), false);
+        if (symbol != SymbolTable::EPSILON && !inAlphabet[symbol])
+        {
+            inAlphabet[symbol] = true;
+            if (!haveAlphabet)
+                alphabet.push_back(symbol);
+        }
+    }
+    if (initial == SymbolTable::NPOS)
+        throw std::invalid_argument("FiniteAutomaton::fromText: missing %initial");
+
+    return FiniteAutomaton(std::move(table), std::move(states), std::move(alphabet), transitions, initial, finals);
+}
+FiniteAutomaton FiniteAutomaton::loadText(const std::string& path)
+{
+    MappedFile file {path};
+    return fromText(file.view());
+}
+void FiniteAutomaton::saveText(std::ostream& out) const
+{
+    out << "%states";
+    for (SymbolId id : m_stateIds)
+        out << ' ' << m_symbols->name(id);
+    out << "\n%alphabet";
+    for (SymbolId a : m_alphabet)
+        out << ' ' << m_symbols->name(a);
+    out << "\n%initial " << initialState() << "\n%final";
+    for (std::size_t s = 0; s < m_stateIds.size(); ++s)
+        if (m_final[s])
+            out << ' ' << stateName(s);
+    out << '\n';
+    for (std::size_t s = 0; s < m_stateIds.size(); ++s)
+        for (auto t = transitionsBegin(s); t != transitionsEnd(s); ++t)
+            out << stateName(s) << ' ' << (t->symbol == SymbolTable::EPSILON ? "ε" : m_symbols->name(t->symbol))
+                << ' ' << stateName(t->to) << '\n';
+}
+FiniteAutomaton FiniteAutomaton::reorderStates(const std::vector<std::string_view>& corpus) const
+{
+    FiniteAutomaton fa {*this};
+    if (m_dfa)
+        fa.m_dfa = std::make_shared<const CompiledDFA>(
+            m_dfa->reordered(corpus.empty() ? std::vector<std::uint64_t>{} : m_dfa->profile(corpus)));
+    return fa;
+}
+
+FiniteAutomaton FiniteAutomaton::withTableBudget(std::size_t budgetBytes) const
+{
+    FiniteAutomaton fa {*this};
+    if (m_dfa && m_dfa->tableBytes() > budgetBytes)
+    {
+        auto packed = std::make_shared<const PackedDFA>(*m_dfa);
+        if (packed->tableBytes() < m_dfa->tableBytes())
+        {
+            fa.m_packed = std::move(packed);
+            fa.m_dfa.reset();
+        }
+    }
+    return fa;
+}
+
+FiniteAutomaton FiniteAutomaton::withWeights(std::vector<double> transitionWeights,
+                                             std::vector<double> stopWeights) const
+{
+    if (transitionWeights.size() != m_transitions.size())
+        throw std::invalid_argument("FiniteAutomaton: expected " + std::to_string(m_transitions.size())
+                                    + " transition weights, got " + std::to_string(transitionWeights.size()));
+    if (!stopWeights.empty() && stopWeights.size() != m_stateIds.size())
+        throw std::invalid_argument("FiniteAutomaton: expected " + std::to_string(m_stateIds.size())
+                                    + " stop weights, got " + std::to_string(stopWeights.size()));
+    for (const auto* weights : {&transitionWeights, &stopWeights})
+        for (double w : *weights)
+            if (!(w >= 0) || !std::isfinite(w))
+                throw std::invalid_argument("FiniteAutomaton: weights must be finite and non-negative");
+    FiniteAutomaton fa {*this};
+    fa.m_weights = std::move(transitionWeights);
+    fa.m_stopWeights = std::move(stopWeights);
+    return fa;
+}
+FiniteAutomaton FiniteAutomaton::learnWeights(const std::vector<std::string_view>& corpus, double smoothing) const
+{
+    std::vector<double> counts(m_transitions.size(), smoothing);
+    std::vector<double> stops(m_stateIds.size(), smoothing);
+    const std::size_t n {m_stateIds.size()};
+
+    // breadth-first over (position, state), epsilon moves staying in place;
+    // the node key is position * n + state, mapped to {parent key, transition}
+    struct Step { std::uint64_t parent; std::uint32_t transition; };
+    std::unordered_map<std::uint64_t, Step> seen {};
+    std::vector<std::uint64_t> queue {};
+    for (std::string_view word : corpus)
+    {
+        if (n == 0)
+            break;
+        seen.clear();
+        queue.assign(1, m_initialIndex);
+        seen.emplace(m_initialIndex, Step {m_initialIndex, 0});
+        std::uint64_t end {~std::uint64_t{0}};
+        for (std::size_t head = 0; head < queue.size() && end == ~std::uint64_t{0}; ++head)
+        {
+            const std::uint64_t key {queue[head]};
+            const std::size_t position {key / n};
+            const std::size_t state {key % n};
+            if (position == word.size() && m_final[state])
+            {
+                end = key;
+                break;
+            }
+            for (auto t = transitionsBegin(state); t != transitionsEnd(state); ++t)
+            {
+                const Symbol& name {m_symbols->name(t->symbol)};
+                if (word.compare(position, name.size(), name) != 0)
+                    continue;
+                const std::uint64_t next {(position + name.size()) * n + t->to};
+                if (seen.emplace(next, Step {key, static_cast<std::uint32_t>(t - m_transitions.data())}).second)
+                    queue.push_back(next);
+            }
+        }
+        if (end == ~std::uint64_t{0})
+            continue; // not accepted
+        stops[end % n] += 1;
+        for (std::uint64_t key = end; key != m_initialIndex; key = seen[key].parent)
+            counts[seen[key].transition] += 1;
+    }
+    for (std::size_t s = 0; s < n; ++s)
+        if (!m_final[s])
+            stops[s] = 0;
+    return withWeights(std::move(counts), std::move(stops));
+}
+
+FiniteAutomaton::Stats FiniteAutomaton::stats() const
+{
+    Stats stats {stateCount(), transitionCount(), 0, 0};
+    if (m_dfa)
+    {
+        stats.classes = m_dfa->classCount();
+        stats.tableBytes = m_dfa->tableBytes();
+    }
+    else if (m_packed)
+    {
+        stats.classes = m_packed->classCount();
+        stats.tableBytes = m_packed->tableBytes();
+        stats.packed = true;
+    }
+    else if (m_nfa)
+    {
+        stats.classes = m_nfa->symbolCount() + 1; // plus the class of unused bytes
+        stats.tableBytes = m_nfa->tableBytes();
+    }
+    return stats;
+}
 void FiniteAutomaton::print() const
     {
         std::cout << "States: { ";
-        for (const auto& s : m_states)
+        for (const auto& s : states())
             std::cout << s << " ";
         std::cout << "}\n";
 
         std::cout << "Alphabet: { ";
-        for (const auto& a : m_alphabet)
+        for (const auto& a : alphabet())
             std::cout << a << " ";
         std::cout << "}\n";
 
-        std::cout << "Initial state: " << m_initialState << "\n";
+        std::cout << "Initial state: " << initialState() << "\n";
 
         std::cout << "Final states: { ";
-        for (const auto& f : m_finalStates)
+        for (const auto& f : finalStates())
             std::cout << f << " ";
         std::cout << "}\n";
 
         std::cout << "Transitions:\n";
-        for (const auto& [key, destinations] : m_transitions)
+        for (const auto& [key, destinations] : transitions())
         {
             const auto& [from, input] = key;
             for (const auto& to : destinations)
@@ -46,160 +447,447 @@ void FiniteAutomaton::print() const
 //this assumes that all symbols are a single character
 bool FiniteAutomaton::stringBelongsToLanguage(std::string_view input) const
 {
-    std::set<Symbol> currentStates { m_initialState };
+    if (m_dfa)
+        return m_dfa->matches(input);
+    if (m_packed)
+        return m_packed->matches(input);
+    if (m_nfa)
+        return m_nfa->matches(input);
+    return false; // default-constructed automaton
+}
 
-    for (char c : input)
-    {
-        Symbol symbol(1, c); // convert char → string
-        std::set<Symbol> nextStates;
+void FiniteAutomaton::matchBatch(const std::vector<std::string_view>& inputs, std::vector<std::uint8_t>& out,
+                                 BatchOptions options) const
+{
+    const std::size_t blockSize {4096}; // inputs per task, handed out dynamically
+    out.resize(inputs.size());
+    const std::size_t blocks {(inputs.size() + blockSize - 1) / blockSize};
+    unsigned threads {options.threads ? options.threads : std::max(1U, std::thread::hardware_concurrency())};
 
-        for (const auto& state : currentStates)
+    auto runBlock = [&](std::size_t b) {
+        const std::size_t first {b * blockSize};
+        const std::size_t count {std::min(blockSize, inputs.size() - first)};
+        if (m_dfa)
         {
-            auto it = m_transitions.find({state, symbol});
-            if (it != m_transitions.end())
-            {
-                nextStates.insert(it->second.begin(), it->second.end());
-            }
+            m_dfa->matchMany(inputs.data() + first, count, out.data() + first, options.interleave);
+            return;
         }
+        for (std::size_t i = first; i < first + count; ++i)
+            out[i] = stringBelongsToLanguage(inputs[i]);
+    };
+    ThreadPool::shared().parallelFor(blocks, threads, runBlock);
+}
 
-        if (nextStates.empty())
-            return false; // no transitions → dead end
+Searcher FiniteAutomaton::searcher() const
+{
+    return Searcher(*this);
+}
 
-        currentStates = std::move(nextStates);
-    }
+MatcherState FiniteAutomaton::matcher() const
+{
+    return MatcherState(m_dfa, m_nfa, m_packed);
+}
+
+LazyDFA FiniteAutomaton::lazyDFA(std::size_t cacheBytes) const
+{
+    return LazyDFA(*this, cacheBytes);
+}
 
-    // Accept if any current state is final
-    for (const auto& state : currentStates)
+ApproximateMatcher FiniteAutomaton::approximateMatcher(std::size_t maxEdits) const
+{
+    return ApproximateMatcher(*this, maxEdits);
+}
+
+std::size_t FiniteAutomaton::editDistance(std::string_view input, std::size_t maxEdits) const
+{
+    return ApproximateMatcher(*this, maxEdits).distance(input);
+}
+
+Grammar FiniteAutomaton::toGrammar() const
+{
+    // names are unchanged, so the grammar shares this automaton's symbol table
+    const SymbolId x {m_symbols->find("X")};
+    std::vector<SymbolId> nonterminals {};
+    for (SymbolId id : m_stateIds)
+        if (id != x)
+            nonterminals.push_back(id);
+
+    ProductionList productions {};
+    for (std::size_t s = 0; s < m_stateIds.size(); ++s)
     {
-        if (m_finalStates.find(state) != m_finalStates.end())
-            return true;
+        const SymbolId from {m_stateIds[s]};
+        if (from == x) continue; // skip transitions from X
+        for (auto t = transitionsBegin(s); t != transitionsEnd(s); ++t)
+        {
+            const SymbolId to {m_stateIds[t->to]};
+            // If destination is X (accepting) or another final state, only add the terminal
+            if (to == x || m_final[t->to])
+                productions.add({from}, {t->symbol});
+            else
+                productions.add({from}, {t->symbol, to});
+        }
     }
 
+    return Grammar(m_symbols, m_alphabet, std::move(nonterminals), m_initialState, std::move(productions));
+}
+bool FiniteAutomaton::isDeterministic() const
+{
+    // rows are sorted by symbol, so a repeated symbol sits next to itself
+    for (std::size_t s = 0; s < m_stateIds.size(); ++s)
+        for (auto t = transitionsBegin(s) + 1; t < transitionsEnd(s); ++t)
+            if (t->symbol == (t - 1)->symbol)
+                return false;
+    return true;
+}
+bool FiniteAutomaton::hasEpsilonMoves() const
+{
+    for (const auto& t : m_transitions)
+        if (t.symbol == SymbolTable::EPSILON)
+            return true;
     return false;
 }
+FiniteAutomaton FiniteAutomaton::reduce(ReductionReport* report) const
+{
+    DenseNFA nfa {*this};
+    NFAReducer reducer {nfa};
+    ReductionReport r {};
+    r.statesBefore = reducer.stateCount();
+    r.transitionsBefore = reducer.edges().size();
+    reducer.trim();
+    r.afterTrim = reducer.stateCount();
+    reducer.mergeBisimilar(false);
+    r.afterForward = reducer.stateCount();
+    reducer.mergeBisimilar(true);
+    r.afterBackward = reducer.stateCount();
+    r.prunedTransitions = reducer.applySimulation(SIMULATION_LIMIT);
+    r.afterSimulation = reducer.stateCount();
 
-Grammar FiniteAutomaton::toGrammar() const
+    const std::size_t n {reducer.stateCount()};
+    std::vector<std::uint32_t> initials {};
+    for (std::uint32_t q = 0; q < n; ++q)
+        if (reducer.isInitial(q))
+            initials.push_back(q);
+    // several initial states: a fresh one, index n, takes the union of their moves
+    const bool fresh {initials.size() > 1};
+    std::vector<SymbolId> names {};
+    auto symbols = withStateNames(*m_symbols, std::max<std::size_t>(n + fresh, 1), names);
+    std::vector<SymbolId> finals {};
+    for (std::size_t q = 0; q < n; ++q)
+        if (reducer.isFinal(q))
+            finals.push_back(names[q]);
+    std::vector<TransitionIds> transitions {};
+    for (const auto& e : reducer.edges())
+    {
+        transitions.push_back({names[e.from], nfa.symbolIds[e.symbol], names[e.to]});
+        if (fresh && reducer.isInitial(e.from))
+            transitions.push_back({names[n], nfa.symbolIds[e.symbol], names[e.to]});
+    }
+    if (fresh && std::any_of(initials.begin(), initials.end(), [&](std::uint32_t q) { return reducer.isFinal(q); }))
+        finals.push_back(names[n]);
+    // empty language: a single non-final state
+    const SymbolId initial {fresh ? names[n] : initials.empty() ? names[0] : names[initials[0]]};
+
+    FiniteAutomaton reduced(std::move(symbols), names, m_alphabet, transitions, initial, finals);
+    r.statesAfter = reduced.stateCount();
+    r.transitionsAfter = reduced.transitionCount();
+    if (report)
+        *report = r;
+    return reduced;
+}
+FiniteAutomaton FiniteAutomaton::toDFA(bool minimizeResult, std::size_t stateBudget, bool reduceFirst) const
+{
+    const bool reducible {reduceFirst && (!isDeterministic() || hasEpsilonMoves())};
+    const FiniteAutomaton dfa {reducible ? reduce().subsetConstruction(stateBudget) : subsetConstruction(stateBudget)};
+    return minimizeResult ? dfa.minimize() : dfa;
+}
+FiniteAutomaton FiniteAutomaton::subsetConstruction(std::size_t stateBudget) const
 {
-    std::set<Symbol> terminals{};
-    std::set<Symbol> nonterminals{};
-    Symbol start{m_initialState};
-    std::vector<Production> productions{};
+    // Subset construction algorithm (handles epsilon-NFA, NFA → DFA).
+    // Subsets are bitsets over the dense state ids of the NFA, interned in a
+    // SubsetTable; DFA ids are the table ids, so discovery order is preserved.
+    DenseNFA nfa {*this};
+    SubsetTable table {nfa.words};
+    table.insert(nfa.start.data());
 
-    for (const auto& state : m_states)
-        if (state != "X")
-            nonterminals.insert(state);
-    
-    for (const auto& letter : m_alphabet)
-        terminals.insert(letter);
-    
-    for (const auto& p : m_transitions)
+    struct Edge { std::uint32_t from, symbol, to; };
+    std::vector<Edge> edges {};
+    std::vector<std::uint64_t> next(nfa.words, 0);
+    for (std::size_t i = 0; i < table.size(); ++i)
     {
-        if (p.first.first == "X") continue; // skip transitions from X
-        for(const auto& symbol : p.second)
+        for (std::size_t a = 0; a < nfa.symbolCount(); ++a)
         {
-            if (symbol == "X") 
+            // the view is re-read each time: inserting may move the pool
+            if (!nfa.move(table.view(i), a, next.data()))
+                continue; // no move on this symbol
+            std::size_t to {table.find(next.data())};
+            if (to == SubsetTable::NPOS)
             {
-                // If destination is X (accepting), only add terminal production
-                Production temp{};
-                temp.lhs.push_back(p.first.first);
-                temp.rhs.push_back(p.first.second);
-                productions.push_back(temp);
-            }
-            else 
-            {
-                Production temp{};
-                temp.lhs.push_back(p.first.first);
-                temp.rhs.push_back(p.first.second);
-                // If destination is a final state, do not add the next state
-                if (m_finalStates.find(symbol) == m_finalStates.end()) 
-                {
-                    temp.rhs.push_back(symbol);
-                }
-                productions.push_back(temp);
+                if (table.size() == stateBudget)
+                    throw StateBudgetExceeded(stateBudget);
+                to = table.insert(next.data());
             }
+            std::fill(next.begin(), next.end(), 0);
+            edges.push_back({static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(a), static_cast<std::uint32_t>(to)});
         }
     }
 
+    std::vector<SymbolId> names {};
+    auto symbols = withStateNames(*m_symbols, table.size(), names);
+    std::vector<SymbolId> finals {};
+    for (std::size_t id = 0; id < table.size(); ++id)
+        if (nfa.intersectsFinals(table.view(id)))
+            finals.push_back(names[id]);
+    std::vector<TransitionIds> transitions {};
+    transitions.reserve(edges.size());
+    for (const auto& e : edges)
+        transitions.push_back({names[e.from], nfa.symbolIds[e.symbol], names[e.to]});
 
-    return Grammar (terminals, nonterminals, start, productions);
-    
+    return FiniteAutomaton(std::move(symbols), names, m_alphabet, transitions, names[0], finals);
 }
-bool FiniteAutomaton::isDeterministic() const
+bool FiniteAutomaton::includedIn(const FiniteAutomaton& other, std::string* counterexample) const
 {
-    for(const auto& t : m_transitions)
-        if (t.second.size() > 1)
-            return false;
-    return true;
+    // reduction keeps both languages, so shortest counterexamples keep their length
+    const std::optional<std::string> excess {shortestExcess(DenseNFA {reduce()}, DenseNFA {other.reduce()})};
+    if (excess && counterexample)
+        *counterexample = *excess;
+    return !excess;
 }
-FiniteAutomaton FiniteAutomaton::toDFA() const
-{
-    // Subset construction algorithm (handles epsilon-NFA, NFA → DFA)
-    using StateSet = std::set<Symbol>;
-    std::map<StateSet, Symbol> stateSetToName;
-    std::vector<StateSet> dfaStates;
-    std::set<Symbol> dfaStateNames;
-    std::set<Symbol> dfaFinalStates;
-    std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> dfaTransitions;
-
-    // Helper: compute epsilon closure of a set of states
-    auto epsilonClosure = [&](const StateSet& states) {
-        StateSet closure = states;
-        std::vector<Symbol> stack(closure.begin(), closure.end());
-        while (!stack.empty()) {
-            Symbol s = stack.back(); stack.pop_back();
-            auto it = m_transitions.find({s, ""}); // "" is epsilon
-            if (it != m_transitions.end()) {
-                for (const auto& next : it->second) {
-                    if (closure.insert(next).second)
-                        stack.push_back(next);
+bool FiniteAutomaton::equivalentTo(const FiniteAutomaton& other, std::string* counterexample) const
+{
+    std::optional<std::string> difference {};
+    if (isDeterministic() && !hasEpsilonMoves() && other.isDeterministic() && !other.hasEpsilonMoves())
+    {
+        const DenseNFA mine {*this};
+        const DenseNFA theirs {other};
+        if (equivalentDFAs(mine, theirs))
+            return true;
+        difference = shortestDifference(mine, theirs);
+    }
+    else
+    {
+        const DenseNFA x {reduce()};
+        const DenseNFA y {other.reduce()};
+        difference = shortestExcess(x, y);
+        const std::optional<std::string> missing {shortestExcess(y, x)};
+        if (!difference || (missing && missing->size() < difference->size()))
+            difference = missing;
+    }
+    if (difference && counterexample)
+        *counterexample = *difference;
+    return !difference;
+}
+FiniteAutomaton FiniteAutomaton::minimize() const
+{
+    if (!isDeterministic() || hasEpsilonMoves())
+        return toDFA().minimize();
+
+    // states are the automaton's own indices; state n is an explicit sink
+    const std::vector<SymbolId> symbols {inputSymbols()};
+    std::vector<int> column(m_symbols->size(), -1);
+    for (std::size_t a = 0; a < symbols.size(); ++a)
+        column[symbols[a]] = static_cast<int>(a);
+
+    const int n {static_cast<int>(m_stateIds.size())};
+    const int sink {n};
+    const int init {static_cast<int>(m_initialIndex)};
+    const int k {static_cast<int>(symbols.size())};
+    std::vector<int> delta(static_cast<size_t>(n + 1) * k, sink);
+    for (int s = 0; s < n; ++s)
+        for (auto t = transitionsBegin(s); t != transitionsEnd(s); ++t)
+            delta[static_cast<size_t>(s) * k + column[t->symbol]] = static_cast<int>(t->to);
+    std::vector<bool> isFinal(n + 1, false);
+    for (int s = 0; s < n; ++s)
+        isFinal[s] = m_final[s] != 0;
+
+    // reverse CSR: pre[offset[a * (n+1) + t] ..] are the states s with delta(s, a) = t
+    const int total {n + 1};
+    std::vector<int> preOffset(static_cast<size_t>(k) * total + 1, 0);
+    for (int s = 0; s < total; ++s)
+        for (int a = 0; a < k; ++a)
+            ++preOffset[static_cast<size_t>(a) * total + delta[static_cast<size_t>(s) * k + a] + 1];
+    for (size_t i = 1; i < preOffset.size(); ++i)
+        preOffset[i] += preOffset[i - 1];
+    std::vector<int> pre(preOffset.back());
+    {
+        std::vector<int> fill(preOffset.begin(), preOffset.end() - 1);
+        for (int s = 0; s < total; ++s)
+            for (int a = 0; a < k; ++a)
+                pre[fill[static_cast<size_t>(a) * total + delta[static_cast<size_t>(s) * k + a]]++] = s;
+    }
+
+    // keep only states that are reachable and can still reach a final state
+    std::vector<bool> reachable(total, false);
+    std::vector<int> stack {init};
+    reachable[init] = true;
+    while (!stack.empty())
+    {
+        int s {stack.back()};
+        stack.pop_back();
+        for (int a = 0; a < k; ++a)
+        {
+            int t {delta[static_cast<size_t>(s) * k + a]};
+            if (!reachable[t])
+            {
+                reachable[t] = true;
+                stack.push_back(t);
+            }
+        }
+    }
+    std::vector<bool> live(total, false);
+    for (int s = 0; s < n; ++s)
+        if (isFinal[s])
+        {
+            live[s] = true;
+            stack.push_back(s);
+        }
+    while (!stack.empty())
+    {
+        int t {stack.back()};
+        stack.pop_back();
+        for (int a = 0; a < k; ++a)
+            for (int i = preOffset[static_cast<size_t>(a) * total + t]; i < preOffset[static_cast<size_t>(a) * total + t + 1]; ++i)
+                if (!live[pre[i]])
+                {
+                    live[pre[i]] = true;
+                    stack.push_back(pre[i]);
                 }
+    }
+
+    if (!live[init])
+    {
+        // empty language
+        std::vector<SymbolId> names {};
+        auto table = withStateNames(*m_symbols, 1, names);
+        return FiniteAutomaton(std::move(table), names, m_alphabet, {}, names[0], {});
+    }
+
+    // Hopcroft: blocks are ranges [first, last) of elems; marked states are swapped to the front
+    std::vector<int> elems(total), loc(total), blockOf(total);
+    std::vector<int> first {}, last {}, marked {};
+    std::vector<bool> inWork {};
+    std::vector<int> work {};
+    {
+        // initial partition: useless states (incl. sink), non-final, final
+        std::vector<int> groups[3];
+        for (int s = 0; s < total; ++s)
+        {
+            bool useful {reachable[s] && live[s]};
+            groups[!useful ? 0 : (isFinal[s] ? 2 : 1)].push_back(s);
+        }
+        int pos {0};
+        for (const auto& g : groups)
+        {
+            if (g.empty())
+                continue;
+            int b {static_cast<int>(first.size())};
+            first.push_back(pos);
+            for (int s : g)
+            {
+                elems[pos] = s;
+                loc[s] = pos++;
+                blockOf[s] = b;
             }
+            last.push_back(pos);
+            marked.push_back(0);
+            inWork.push_back(true);
+            work.push_back(b);
         }
-        return closure;
-    };
+    }
 
-    // Start with epsilon closure of initial state
-    StateSet startClosure = epsilonClosure({m_initialState});
-    dfaStates.push_back(startClosure);
-    stateSetToName[startClosure] = "Q0";
-    dfaStateNames.insert("Q0");
-    if (std::any_of(startClosure.begin(), startClosure.end(), [&](const Symbol& s){ return m_finalStates.count(s); }))
-        dfaFinalStates.insert("Q0");
-
-    size_t stateCount = 1;
-    for (size_t i = 0; i < dfaStates.size(); ++i) {
-        Symbol dfaStateName = stateSetToName[dfaStates[i]];
-        for (const auto& input : m_alphabet) {
-            if (input.empty()) continue; // skip epsilon
-            StateSet nextSet;
-            for (const auto& s : dfaStates[i]) {
-                auto it = m_transitions.find({s, input});
-                if (it != m_transitions.end()) {
-                    nextSet.insert(it->second.begin(), it->second.end());
+    std::vector<int> touched {}, splitter {};
+    while (!work.empty())
+    {
+        int w {work.back()};
+        work.pop_back();
+        inWork[w] = false;
+        splitter.assign(elems.begin() + first[w], elems.begin() + last[w]);
+
+        for (int a = 0; a < k; ++a)
+        {
+            for (int t : splitter)
+            {
+                for (int i = preOffset[static_cast<size_t>(a) * total + t]; i < preOffset[static_cast<size_t>(a) * total + t + 1]; ++i)
+                {
+                    int s {pre[i]};
+                    int b {blockOf[s]};
+                    if (loc[s] < first[b] + marked[b])
+                        continue; // already marked
+                    if (marked[b] == 0)
+                        touched.push_back(b);
+                    int dst {first[b] + marked[b]++};
+                    int other {elems[dst]};
+                    std::swap(elems[dst], elems[loc[s]]);
+                    loc[other] = loc[s];
+                    loc[s] = dst;
                 }
             }
-            // Take epsilon closure of the result
-            nextSet = epsilonClosure(nextSet);
-            if (nextSet.empty()) continue;
-            // Assign a name if not already present
-            if (!stateSetToName.count(nextSet)) {
-                Symbol name = "Q" + std::to_string(stateCount++);
-                stateSetToName[nextSet] = name;
-                dfaStates.push_back(nextSet);
-                dfaStateNames.insert(name);
-                if (std::any_of(nextSet.begin(), nextSet.end(), [&](const Symbol& s){ return m_finalStates.count(s); }))
-                    dfaFinalStates.insert(name);
+            for (int b : touched)
+            {
+                int m {marked[b]};
+                marked[b] = 0;
+                if (m == last[b] - first[b])
+                    continue;
+                // marked prefix becomes a new block
+                int nb {static_cast<int>(first.size())};
+                first.push_back(first[b]);
+                last.push_back(first[b] + m);
+                marked.push_back(0);
+                first[b] += m;
+                for (int i = first[nb]; i < last[nb]; ++i)
+                    blockOf[elems[i]] = nb;
+                if (inWork[b])
+                {
+                    inWork.push_back(true);
+                    work.push_back(nb);
+                }
+                else
+                {
+                    int smaller {(last[nb] - first[nb]) <= (last[b] - first[b]) ? nb : b};
+                    inWork.push_back(false);
+                    inWork[smaller] = true;
+                    work.push_back(smaller);
+                }
             }
-            // Add transition
-            dfaTransitions[{dfaStateName, input}].insert(stateSetToName[nextSet]);
+            touched.clear();
         }
     }
 
-    // DFA only: transitions are single-valued
-    std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> dfaTransitionsSingle;
-    for (const auto& t : dfaTransitions) {
-        dfaTransitionsSingle[{t.first.first, t.first.second}].insert(*t.second.begin());
+    // name the useful blocks Q0, Q1, ... in BFS order from the initial state
+    std::vector<int> blockName(first.size(), -1);
+    std::vector<int> queue {blockOf[init]};
+    blockName[blockOf[init]] = 0;
+    struct Edge { int from, symbol, to; };
+    std::vector<Edge> edges {};
+    std::vector<int> finalBlocks {};
+    for (size_t qi = 0; qi < queue.size(); ++qi)
+    {
+        int b {queue[qi]};
+        int rep {elems[first[b]]};
+        if (isFinal[rep])
+            finalBlocks.push_back(static_cast<int>(qi));
+        for (int a = 0; a < k; ++a)
+        {
+            int t {delta[static_cast<size_t>(rep) * k + a]};
+            if (!reachable[t] || !live[t])
+                continue;
+            int tb {blockOf[t]};
+            if (blockName[tb] < 0)
+            {
+                blockName[tb] = static_cast<int>(queue.size());
+                queue.push_back(tb);
+            }
+            edges.push_back({static_cast<int>(qi), a, blockName[tb]});
+        }
     }
 
-    return FiniteAutomaton(dfaStateNames, m_alphabet, dfaTransitionsSingle, "Q0", dfaFinalStates);
+    std::vector<SymbolId> names {};
+    auto table = withStateNames(*m_symbols, queue.size(), names);
+    std::vector<SymbolId> finals {};
+    for (int f : finalBlocks)
+        finals.push_back(names[f]);
+    std::vector<TransitionIds> transitions {};
+    transitions.reserve(edges.size());
+    for (const auto& e : edges)
+        transitions.push_back({names[e.from], symbols[e.symbol], names[e.to]});
+    return FiniteAutomaton(std::move(table), names, m_alphabet, transitions, names[0], finals);
 }
@@ -6,9 +6,67 @@
 #include <set>
 #include <map>
 #include <iostream>
+#include <memory>
+#include <string_view>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "symbolTable.h"
 class Grammar;
+class CompiledDFA;
+class PackedDFA;
+class BitParallelNFA;
+class LazyDFA;
+class MatcherState;
+class Searcher;
+class ApproximateMatcher;
 
 using Symbol = std::string;
+using SymbolId = SymbolTable::Id;
+
+// one outgoing edge in the CSR transition arrays; `to` is a state index
+struct Transition
+{
+    SymbolId symbol;
+    std::uint32_t to;
+};
+
+// a transition named by symbol-table ids, as taken by the id-based constructor
+struct TransitionIds
+{
+    SymbolId from;
+    SymbolId symbol;
+    SymbolId to;
+};
+
+// thrown by toDFA() when the subset construction outgrows its state budget
+class StateBudgetExceeded : public std::runtime_error
+{
+public:
+    explicit StateBudgetExceeded(std::size_t budget)
+        : std::runtime_error("StateBudgetExceeded: more than " + std::to_string(budget) + " DFA states") {}
+};
+
+// sizes after each step of FiniteAutomaton::reduce()
+struct ReductionReport
+{
+    std::size_t statesBefore {0};
+    std::size_t transitionsBefore {0};   // epsilon moves folded in
+    std::size_t afterTrim {0};
+    std::size_t afterForward {0};        // forward bisimulation quotient
+    std::size_t afterBackward {0};       // backward bisimulation quotient
+    std::size_t afterSimulation {0};     // simulation quotient and pruning, trimmed again
+    std::size_t prunedTransitions {0};   // dropped as simulated by a sibling
+    std::size_t statesAfter {0};         // including an added initial state
+    std::size_t transitionsAfter {0};
+};
+
+struct BatchOptions
+{
+    unsigned threads {0};     // 0 = std::thread::hardware_concurrency()
+    unsigned interleave {1};  // inputs stepped together per thread (1, 2, 4 or 8)
+};
 
 class FiniteAutomaton
 {
@@ -16,31 +74,155 @@ class FiniteAutomaton
     FiniteAutomaton(std::set<Symbol> states, std::set<Symbol> alphabet,
                     std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> transitions,
                     Symbol initialState, std::set<Symbol> finalStates);
+    // id-based form used by the conversions; every id must belong to `symbols`.
+    // States referenced only by transitions, the initial or final states are added.
+    FiniteAutomaton(std::shared_ptr<const SymbolTable> symbols, std::vector<SymbolId> states,
+                    std::vector<SymbolId> alphabet, const std::vector<TransitionIds>& transitions,
+                    SymbolId initialState, const std::vector<SymbolId>& finalStates);
     FiniteAutomaton() = default;
     void print() const;
+
+    // Line-based text form: one "from symbol to" transition per line, "ε" for
+    // epsilon, plus the directives "%initial q", "%final q ...", "%alphabet a ..."
+    // and "%states q ..."; '#' starts a comment. Without %alphabet the alphabet is
+    // every non-epsilon transition symbol. Throws std::invalid_argument naming the line.
+    static FiniteAutomaton fromText(std::string_view text);
+    // memory-maps the file and parses it in a single pass
+    static FiniteAutomaton loadText(const std::string& path);
+    // writes the form read by fromText; names must not contain whitespace
+    void saveText(std::ostream& out) const;
     bool stringBelongsToLanguage(std::string_view) const;
+    // out[i] = stringBelongsToLanguage(inputs[i]), split across the shared thread pool
+    void matchBatch(const std::vector<std::string_view>& inputs, std::vector<std::uint8_t>& out,
+                    BatchOptions options = {}) const;
 
     //============LAB 2==============
     Grammar toGrammar() const;
     bool isDeterministic() const;
-    FiniteAutomaton toDFA() const;
+    static constexpr std::size_t DEFAULT_STATE_BUDGET {1'000'000};
+    // subset construction over bitsets; throws StateBudgetExceeded past stateBudget states.
+    // Non-deterministic input is passed through reduce() first unless reduceFirst is false.
+    FiniteAutomaton toDFA(bool minimizeResult = false, std::size_t stateBudget = DEFAULT_STATE_BUDGET,
+                          bool reduceFirst = true) const;
     //============LAB 2==============
 
-    //getters
-    const std::set<Symbol>& states() const { return m_states; }
-    const std::set<Symbol>& alphabet() const { return m_alphabet; }
-    const std::set<Symbol>& finalStates() const { return m_finalStates; }
-    const Symbol& initialState() const { return m_initialState; }
-    const std::map<std::pair<Symbol, Symbol>, std::set<Symbol>>& transitions() const { return m_transitions; }
+    // language-preserving NFA reduction: epsilon moves folded, useless states
+    // trimmed, forward then backward bisimilar states merged and, up to
+    // SIMULATION_LIMIT states, direct simulation applied (see NFAReducer).
+    // States are renamed Q0 ..; several initial states get a fresh one.
+    static constexpr std::size_t SIMULATION_LIMIT {512};
+    FiniteAutomaton reduce(ReductionReport* report = nullptr) const;
+
+    // language comparisons, symbols matched by name across symbol tables. On a
+    // mismatch `counterexample` gets a shortest word accepted by exactly one side
+    // (includedIn: by this automaton only). Deterministic pairs are compared by
+    // Hopcroft–Karp, anything else by antichain inclusion in both directions.
+    bool includedIn(const FiniteAutomaton& other, std::string* counterexample = nullptr) const;
+    bool equivalentTo(const FiniteAutomaton& other, std::string* counterexample = nullptr) const;
+
+    // Hopcroft partition refinement; drops unreachable and dead states.
+    // Non-deterministic automata are determinized first.
+    FiniteAutomaton minimize() const;
+
+    // copy whose compiled DFA rows are laid out hot-first, by visit counts over
+    // `corpus` or, without one, depth-first from the initial state; states and
+    // transitions are unchanged. Automata without a compiled DFA are just copied.
+    FiniteAutomaton reorderStates(const std::vector<std::string_view>& corpus = {}) const;
+
+    // copy that matches with a comb-packed PackedDFA when the dense compiled
+    // table is larger than budgetBytes and packing makes it smaller
+    FiniteAutomaton withTableBudget(std::size_t budgetBytes) const;
+
+    // copy carrying weights for WordGenerator: transitionWeights[i] is transition i
+    // in CSR order (state 0's row first), stopWeights[s] the weight of ending a word
+    // at final state s (empty: all 1). Weights must be finite and >= 0; the
+    // conversions (toDFA, minimize, ...) drop them.
+    FiniteAutomaton withWeights(std::vector<double> transitionWeights, std::vector<double> stopWeights = {}) const;
+    // weights counted over the accepted words of `corpus`: each adds 1 to the
+    // transitions on one accepting path (fewest steps) and to the state it ends
+    // in, on top of `smoothing` for every transition and final state
+    FiniteAutomaton learnWeights(const std::vector<std::string_view>& corpus, double smoothing = 1.0) const;
+
+    // finds every leftmost-longest occurrence of the language inside a text
+    Searcher searcher() const;
+    // resumable matcher for input that arrives in chunks
+    MatcherState matcher() const;
+    // matcher that determinizes on the fly into a cache of at most cacheBytes
+    LazyDFA lazyDFA(std::size_t cacheBytes = 1 << 20) const;
+
+    // matcher for inputs within maxEdits byte edits of the language (see ApproximateMatcher)
+    ApproximateMatcher approximateMatcher(std::size_t maxEdits) const;
+    // fewest insertions, deletions and substitutions that make `input` accepted,
+    // or ApproximateMatcher::NPOS past maxEdits; builds a matcher per call
+    std::size_t editDistance(std::string_view input, std::size_t maxEdits) const;
+
+    //getters: states are dense indices 0 .. stateCount()-1, names live in symbols()
+    const SymbolTable& symbols() const { return *m_symbols; }
+    const std::shared_ptr<const SymbolTable>& symbolTable() const { return m_symbols; }
+    std::size_t stateCount() const { return m_stateIds.size(); }
+    SymbolId stateId(std::size_t state) const { return m_stateIds[state]; }
+    const Symbol& stateName(std::size_t state) const { return m_symbols->name(m_stateIds[state]); }
+    std::uint32_t initialIndex() const { return m_initialIndex; }
+    bool isFinal(std::size_t state) const { return m_final[state] != 0; }
+    // sorted by name
+    const std::vector<SymbolId>& alphabetIds() const { return m_alphabet; }
+    // alphabet plus any other symbol used by a transition, epsilon excluded, sorted by name
+    std::vector<SymbolId> inputSymbols() const;
+    const Transition* transitionsBegin(std::size_t state) const { return m_transitions.data() + m_transitionOffsets[state]; }
+    const Transition* transitionsEnd(std::size_t state) const { return m_transitions.data() + m_transitionOffsets[state + 1]; }
+    std::size_t transitionCount() const { return m_transitions.size(); }
+    bool isWeighted() const { return !m_weights.empty(); }
+    // 1 when the automaton is unweighted
+    double transitionWeight(std::size_t transition) const { return m_weights.empty() ? 1.0 : m_weights[transition]; }
+    double stopWeight(std::size_t state) const { return m_stopWeights.empty() ? 1.0 : m_stopWeights[state]; }
+
+    // name-based views, built on demand (printing, tests)
+    std::set<Symbol> states() const;
+    std::set<Symbol> alphabet() const;
+    std::set<Symbol> finalStates() const;
+    const Symbol& initialState() const { return m_symbols->name(m_initialState); }
+    std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> transitions() const;
+
+    struct Stats
+    {
+        std::size_t states {0};
+        std::size_t transitions {0};
+        std::size_t classes {0};     // byte equivalence classes (table columns) of the compiled matcher
+        std::size_t tableBytes {0};  // memory held by the compiled matcher's tables
+        bool packed {false};         // the tables are a PackedDFA
+    };
+    Stats stats() const;
+    // null unless the automaton is deterministic without epsilon moves and
+    // not packed by withTableBudget()
+    const CompiledDFA* compiledDFA() const { return m_dfa.get(); }
+    const PackedDFA* packedDFA() const { return m_packed.get(); }
+    // null when compiledDFA() or packedDFA() is set
+    const BitParallelNFA* compiledNFA() const { return m_nfa.get(); }
 
 
     private:
-    std::set<Symbol> m_states {};
-    std::set<Symbol> m_alphabet {};
-    std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> m_transitions {};
-    Symbol m_initialState {};
-    std::set<Symbol> m_finalStates {};
+    void build(std::vector<SymbolId> states, std::vector<SymbolId> alphabet,
+               const std::vector<TransitionIds>& transitions, SymbolId initialState,
+               const std::vector<SymbolId>& finalStates);
+    static const std::shared_ptr<const SymbolTable>& emptySymbols();
+    FiniteAutomaton subsetConstruction(std::size_t stateBudget) const;
+    bool hasEpsilonMoves() const;
+
+    std::shared_ptr<const SymbolTable> m_symbols {emptySymbols()};
+    std::vector<SymbolId> m_stateIds {};               // state index -> name id, ascending
+    std::vector<SymbolId> m_alphabet {};
+    SymbolId m_initialState {SymbolTable::EPSILON};
+    std::uint32_t m_initialIndex {0};
+    std::vector<std::uint8_t> m_final {};              // per state index
+    std::vector<std::uint32_t> m_transitionOffsets {0}; // CSR rows, one per state index
+    std::vector<Transition> m_transitions {};           // sorted by (symbol, to) within a row
+    std::vector<double> m_weights {};                   // per transition, empty = unweighted
+    std::vector<double> m_stopWeights {};               // per state, empty = all 1
 
+    // built once in the constructor, shared read-only between copies
+    std::shared_ptr<const CompiledDFA> m_dfa {};
+    std::shared_ptr<const PackedDFA> m_packed {};
+    std::shared_ptr<const BitParallelNFA> m_nfa {};
 
 };
 
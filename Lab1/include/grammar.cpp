@@ -1,147 +1,240 @@
 #include "grammar.h"
+#include "wordGenerator.h"
 #include <random>
 #include <set>
 #include <algorithm>
 
+namespace
+{
+    // 64-bit FNV-1a
+    std::uint64_t hashOf(const std::string& content)
+    {
+        std::uint64_t hash {0xCBF29CE484222325ULL};
+        for (unsigned char c : content)
+            hash = (hash ^ c) * 0x100000001B3ULL;
+        return hash;
+    }
+}
 
+template <class It>
+void ProductionList::append(It lhsBegin, It lhsEnd, It rhsBegin, It rhsEnd)
+{
+    m_symbols.insert(m_symbols.end(), lhsBegin, lhsEnd);
+    m_rhsStart.push_back(static_cast<std::uint32_t>(m_symbols.size()));
+    m_symbols.insert(m_symbols.end(), rhsBegin, rhsEnd);
+    m_offsets.push_back(static_cast<std::uint32_t>(m_symbols.size()));
+}
+void ProductionList::add(std::initializer_list<SymbolId> lhs, std::initializer_list<SymbolId> rhs)
+{
+    append(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+void ProductionList::add(const std::vector<SymbolId>& lhs, const std::vector<SymbolId>& rhs)
+{
+    append(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
 
 Grammar::Grammar(std::set<Symbol> terminals, std::set<Symbol> nonterminals,
                  Symbol start, std::vector<Production> productions)
-    : m_terminals{terminals}
-    , m_nonterminals{nonterminals}
+{
+    auto table = std::make_shared<SymbolTable>();
+    // sets iterate in name order, so the id vectors come out sorted by name
+    for (const auto& t : terminals)
+        m_terminals.push_back(table->intern(t));
+    for (const auto& nt : nonterminals)
+        m_nonterminals.push_back(table->intern(nt));
+    m_start = table->intern(start);
+    std::vector<SymbolId> lhs{}, rhs{};
+    for (const auto& p : productions)
+    {
+        lhs.clear();
+        rhs.clear();
+        for (const auto& sym : p.lhs)
+            lhs.push_back(table->intern(sym));
+        for (const auto& sym : p.rhs)
+            rhs.push_back(table->intern(sym));
+        m_productions.add(lhs, rhs);
+    }
+    m_symbols = std::move(table);
+    index();
+}
+Grammar::Grammar(std::shared_ptr<const SymbolTable> symbols, std::vector<SymbolId> terminals,
+                 std::vector<SymbolId> nonterminals, SymbolId start, ProductionList productions)
+    : m_symbols{std::move(symbols)}
+    , m_terminals{std::move(terminals)}
+    , m_nonterminals{std::move(nonterminals)}
     , m_start{start}
-    , m_productions{productions}
+    , m_productions{std::move(productions)}
+{
+    auto byName = [this](SymbolId a, SymbolId b) { return m_symbols->name(a) < m_symbols->name(b); };
+    std::sort(m_terminals.begin(), m_terminals.end(), byName);
+    std::sort(m_nonterminals.begin(), m_nonterminals.end(), byName);
+    index();
+}
+void Grammar::index()
 {
+    m_kind.assign(m_symbols->size(), 0);
+    for (SymbolId t : m_terminals)
+        m_kind[t] |= TERMINAL;
+    for (SymbolId nt : m_nonterminals)
+        m_kind[nt] |= NONTERMINAL;
 }
 FiniteAutomaton Grammar::getFiniteAutomaton() const
     {
         //======IMPORTANT - THIS ASSUMES THE GRAMMAR IS A RIGHT LINEAR REGULAR GRAMMAR======
         // IF IT IS NOT, THIS FUNCTION WILL NOT WORK CORRECTLY.
 
-        std::set<Symbol> states {m_nonterminals};
-        states.insert("X"); // extra accepting state
+        // the automaton shares the grammar's names; the table is only copied
+        // when the extra accepting state "X" has to be added to it
+        std::shared_ptr<const SymbolTable> symbols {m_symbols};
+        SymbolId x {m_symbols->find("X")};
+        if (x == SymbolTable::NPOS)
+        {
+            auto table = std::make_shared<SymbolTable>(*m_symbols);
+            x = table->intern("X");
+            symbols = std::move(table);
+        }
 
-        std::set<Symbol> alphabet {m_terminals};
-        Symbol initialState {m_start}; 
-        std::set<Symbol> finalStates {"X"};
+        std::vector<SymbolId> states {m_nonterminals};
+        states.push_back(x); // extra accepting state
 
-        // map (from_state, terminal) -> set of next states (NFA-ready)
-        std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> transitions {};
+        // (from_state, terminal, next state) triples, NFA-ready
+        std::vector<TransitionIds> transitions {};
+        transitions.reserve(m_productions.size());
 
-        for (const auto& production : m_productions)
+        for (std::size_t i = 0; i < m_productions.size(); ++i)
         {
             // For now, only handle single-symbol LHS for FA conversion
-            if (production.lhs.size() != 1) continue;
-            Symbol lhs = production.lhs[0];
+            if (m_productions.lhsSize(i) != 1) continue;
+            const SymbolId lhs {*m_productions.lhsBegin(i)};
+            const SymbolId* rhs {m_productions.rhsBegin(i)};
 
-            if (production.rhs.empty())
+            if (m_productions.rhsSize(i) == 0)
             {
                 // Empty production: treat as terminal-only to accepting state
-                transitions[{lhs, ""}].insert("X"); // "" can represent epsilon if needed
+                transitions.push_back({lhs, SymbolTable::EPSILON, x});
             }
-            else if (production.rhs.size() == 1)
+            else if (m_productions.rhsSize(i) == 1)
             {
                 // Terminal-only production: lhs -> terminal -> X
-                Symbol terminal = production.rhs[0];
-                transitions[{lhs, terminal}].insert("X");
+                transitions.push_back({lhs, rhs[0], x});
             }
             else
             {
                 // Standard right-linear: lhs -> terminal -> next nonterminal
-                Symbol terminal = production.rhs[0];
-                Symbol nextNonterminal = production.rhs[1];
-                transitions[{lhs, terminal}].insert(nextNonterminal);
+                transitions.push_back({lhs, rhs[0], rhs[1]});
             }
         }
-        
-        return FiniteAutomaton {states, alphabet, transitions, initialState, finalStates};
+
+        return FiniteAutomaton {std::move(symbols), std::move(states), m_terminals, transitions, m_start, {x}};
     }
 void Grammar::print() const
     {
         std::cout << "Terminals: { ";
-        for (const auto& t : m_terminals)
-            std::cout << t << " ";
+        for (SymbolId t : m_terminals)
+            std::cout << m_symbols->name(t) << " ";
         std::cout << "}\n";
 
         std::cout << "Nonterminals: { ";
-        for (const auto& nt : m_nonterminals)
-            std::cout << nt << " ";
+        for (SymbolId nt : m_nonterminals)
+            std::cout << m_symbols->name(nt) << " ";
         std::cout << "}\n";
 
-        std::cout << "Start symbol: " << m_start << "\n";
+        std::cout << "Start symbol: " << m_symbols->name(m_start) << "\n";
 
         std::cout << "Productions:\n";
-        for (const auto& prod : m_productions)
+        for (std::size_t i = 0; i < m_productions.size(); ++i)
         {
             std::cout << "  ";
-            for (const auto& sym : prod.lhs)
-                std::cout << sym;
+            for (auto sym = m_productions.lhsBegin(i); sym != m_productions.lhsEnd(i); ++sym)
+                std::cout << m_symbols->name(*sym);
             std::cout << " → ";
-            if (prod.rhs.empty())
+            if (m_productions.rhsSize(i) == 0)
             {
                 std::cout << "ε"; // epsilon for empty RHS
             }
             else
             {
-                for (const auto& sym : prod.rhs)
-                    std::cout << sym;
+                for (auto sym = m_productions.rhsBegin(i); sym != m_productions.rhsEnd(i); ++sym)
+                    std::cout << m_symbols->name(*sym);
             }
             std::cout << "\n";
         }
     }
-const FiniteAutomaton& Grammar::toFiniteAutomaton() const
+std::string Grammar::canonicalForm() const
 {
-    if (!m_faGenerated)
+    // every name is written as "<length>:<name>", so no separator can be faked
+    auto append = [this](std::string& out, SymbolId id) {
+        const Symbol& name {m_symbols->name(id)};
+        out += std::to_string(name.size());
+        out += ':';
+        out += name;
+    };
+    std::string content {"T"};
+    for (SymbolId t : m_terminals)
+        append(content, t);
+    content += "N";
+    for (SymbolId nt : m_nonterminals)
+        append(content, nt);
+    content += "S";
+    append(content, m_start);
+
+    std::vector<std::string> productions(m_productions.size());
+    for (std::size_t i = 0; i < m_productions.size(); ++i)
     {
-        m_cachedFA = getFiniteAutomaton(); // generate only once
-        m_faGenerated = true;
+        for (auto sym = m_productions.lhsBegin(i); sym != m_productions.lhsEnd(i); ++sym)
+            append(productions[i], *sym);
+        productions[i] += "->";
+        for (auto sym = m_productions.rhsBegin(i); sym != m_productions.rhsEnd(i); ++sym)
+            append(productions[i], *sym);
     }
-    return m_cachedFA;
+    std::sort(productions.begin(), productions.end());
+    for (const auto& p : productions)
+        content += "P" + p;
+    return content;
 }
-void Grammar::generateWord() const
+std::uint64_t Grammar::contentHash() const
 {
-    std::random_device rd{};
-    std::seed_seq seed{rd(), rd(), rd(), rd(), rd(), rd(), rd(), rd()};
-    std::mt19937 mt {seed};
-
-    const FiniteAutomaton& fa = m_cachedFA;
-
-    if (!m_faGenerated)
-        toFiniteAutomaton();
-
-    Symbol current_state = fa.initialState();
-    std::string word;
-    const int maxSteps {20};
-
-    for (int steps = 0;
-         steps < maxSteps && fa.finalStates().find(current_state) == fa.finalStates().end();
-         ++steps)
+    return hashOf(canonicalForm());
+}
+GrammarCache::Entry& Grammar::cacheEntry() const
+{
+    std::shared_ptr<GrammarCache::Entry> entry {std::atomic_load(&m_cache)};
+    if (!entry)
     {
-        std::vector<std::pair<Symbol, Symbol>> choices {}; // represents {input, next state}
-
-        for(const auto& [key, destination] : fa.transitions())
-        {
-            const auto& [from, input] = key;
-            if (from == current_state)
-            {
-                for(const auto& next_state : destination)
-                    choices.push_back({input, next_state});
-            }
-        }
-
-        if (choices.empty())
-            break;
-
-        std::uniform_int_distribution<size_t> dist(0, choices.size() - 1);
-        auto [input, next] = choices[dist(mt)];
-
-        if (!input.empty())
-            word += input;
-
-        current_state = next;
+        // racing threads find the same entry, so whichever store wins is fine
+        const std::string content {canonicalForm()};
+        std::shared_ptr<GrammarCache::Entry> found {GrammarCache::shared().find(hashOf(content), content)};
+        std::atomic_compare_exchange_strong(&m_cache, &entry, found);
+        entry = std::atomic_load(&m_cache);
     }
+    // m_cache is never reset, so the entry outlives the reference
+    return *entry;
+}
+const FiniteAutomaton& Grammar::toFiniteAutomaton() const
+{
+    GrammarCache::Entry& entry {cacheEntry()};
+    std::call_once(entry.automatonOnce, [&] { entry.automaton = getFiniteAutomaton(); });
+    return entry.automaton;
+}
+const FiniteAutomaton& Grammar::toMatcher() const
+{
+    const FiniteAutomaton& automaton {toFiniteAutomaton()};
+    GrammarCache::Entry& entry {cacheEntry()};
+    std::call_once(entry.matcherOnce, [&] { entry.matcher = automaton.toDFA(true); });
+    return entry.matcher;
+}
+void Grammar::generateWord() const
+{
+    // one seed source per thread instead of a std::random_device per call
+    thread_local Xoshiro256 seeds {std::random_device {}()};
+    std::string word {};
+    wordGenerator(seeds()).next(word);
     std::cout << word;
 }
+WordGenerator Grammar::wordGenerator(std::uint64_t seed) const
+{
+    return WordGenerator {toFiniteAutomaton(), seed};
+}
 //AKHFASBKJGNASSKMVOIAIWHBFAKSMDLASJFIAB
 void Grammar::classifyGrammar() const
 {
@@ -156,8 +249,8 @@ void Grammar::classifyGrammar() const
 
     // Edge case: needed for context-sensitive grammar (S -> ε allowed only if S not on RHS)
     bool startAppearsOnRHS = false;
-    for (const auto& p : m_productions) {
-        if (std::find(p.rhs.begin(), p.rhs.end(), m_start) != p.rhs.end()) {
+    for (std::size_t i = 0; i < m_productions.size(); ++i) {
+        if (std::find(m_productions.rhsBegin(i), m_productions.rhsEnd(i), m_start) != m_productions.rhsEnd(i)) {
             startAppearsOnRHS = true;
             break; 
         }
@@ -165,33 +258,35 @@ void Grammar::classifyGrammar() const
 
     // === Regular grammar check ===
     // All productions must be either right-linear or left-linear (not both)
-    for (const auto& p : m_productions) 
+    for (std::size_t i = 0; i < m_productions.size(); ++i) 
     {
+        const SymbolId* lhs = m_productions.lhsBegin(i);
+        const SymbolId* rhs = m_productions.rhsBegin(i);
         // LHS must be a single non-terminal
-        if (p.lhs.size() != 1 || m_nonterminals.find(p.lhs[0]) == m_nonterminals.end()) {
+        if (m_productions.lhsSize(i) != 1 || !isNonterminal(lhs[0])) {
             isRegular = false;
             break;
         }
         // RHS: [terminal, non-terminal] (right-linear), [non-terminal, terminal] (left-linear), or [terminal] (terminal-only)
-        if (p.rhs.size() == 2) {
+        if (m_productions.rhsSize(i) == 2) {
             // Right-linear: A -> aB
-            if (m_terminals.find(p.rhs[0]) != m_terminals.end() && m_nonterminals.find(p.rhs[1]) != m_nonterminals.end()) {
+            if (isTerminal(rhs[0]) && isNonterminal(rhs[1])) {
                 foundRightLinear = true;
             // Left-linear: A -> Ba
-            } else if (m_nonterminals.find(p.rhs[0]) != m_nonterminals.end() && m_terminals.find(p.rhs[1]) != m_terminals.end()) {
+            } else if (isNonterminal(rhs[0]) && isTerminal(rhs[1])) {
                 foundLeftLinear = true;
             } else {
                 // Not a valid regular production
                 isRegular = false;
                 break;
             }
-        } else if (p.rhs.size() == 1) {
+        } else if (m_productions.rhsSize(i) == 1) {
             // Terminal-only: A -> a
-            if (!(m_terminals.find(p.rhs[0]) != m_terminals.end())) {
+            if (!isTerminal(rhs[0])) {
                 isRegular = false;
                 break;
             }
-        } else if (p.rhs.empty()) {
+        } else if (m_productions.rhsSize(i) == 0) {
             // Epsilon productions not allowed in regular grammars
             isRegular = false;
             break;
@@ -205,9 +300,9 @@ void Grammar::classifyGrammar() const
 
     // === Context-free grammar check ===
     // LHS must be a single non-terminal, RHS can be any string
-    for (const auto& p : m_productions) 
+    for (std::size_t i = 0; i < m_productions.size(); ++i) 
     {
-        if (p.lhs.size() != 1 || m_nonterminals.find(p.lhs[0]) == m_nonterminals.end()) {
+        if (m_productions.lhsSize(i) != 1 || !isNonterminal(*m_productions.lhsBegin(i))) {
             isContextFree = false;
             break;
         }
@@ -215,18 +310,18 @@ void Grammar::classifyGrammar() const
 
     // === Context-sensitive grammar check ===
     // LHS and RHS are strings, LHS must have at least one non-terminal, |RHS| >= |LHS| (except S -> ε)
-    for (const auto& p : m_productions) 
+    for (std::size_t i = 0; i < m_productions.size(); ++i) 
     {
         bool lhsHasNonTerminal = false;
-        for (const auto& symbol : p.lhs) {
-            if (m_nonterminals.find(symbol) != m_nonterminals.end()) {
+        for (auto symbol = m_productions.lhsBegin(i); symbol != m_productions.lhsEnd(i); ++symbol) {
+            if (isNonterminal(*symbol)) {
                 lhsHasNonTerminal = true;
                 break;
             }
         }
         // Allow S -> ε only if S does not appear on RHS
-        if (p.rhs.empty()) {
-            if (!(p.lhs.size() == 1 && p.lhs[0] == m_start)) {
+        if (m_productions.rhsSize(i) == 0) {
+            if (!(m_productions.lhsSize(i) == 1 && *m_productions.lhsBegin(i) == m_start)) {
                 isContextSensitive = false;
                 break;
             }
@@ -236,7 +331,7 @@ void Grammar::classifyGrammar() const
                 break;
             }
         } else {
-            if (!lhsHasNonTerminal || p.rhs.size() < p.lhs.size()) {
+            if (!lhsHasNonTerminal || m_productions.rhsSize(i) < m_productions.lhsSize(i)) {
                 isContextSensitive = false;
                 break;
             }
@@ -5,7 +5,12 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <memory>
+#include <cstdint>
+#include <initializer_list>
 #include "finiteAutomaton.h"
+#include "grammarCache.h"
+#include "wordGenerator.h"
 
 using Symbol = std::string;
 using RHS = std::vector<Symbol>;
@@ -18,15 +23,52 @@ struct Production
     RHS rhs{};
 };
 
+// productions packed back to back as symbol ids: production i is
+// symbols[offsets[i] .. offsets[i+1]), its rhs starting at rhsStart[i]
+class ProductionList
+{
+public:
+    void add(std::initializer_list<SymbolId> lhs, std::initializer_list<SymbolId> rhs);
+    void add(const std::vector<SymbolId>& lhs, const std::vector<SymbolId>& rhs);
+
+    std::size_t size() const { return m_rhsStart.size(); }
+    const SymbolId* lhsBegin(std::size_t i) const { return m_symbols.data() + m_offsets[i]; }
+    const SymbolId* lhsEnd(std::size_t i) const { return m_symbols.data() + m_rhsStart[i]; }
+    const SymbolId* rhsBegin(std::size_t i) const { return m_symbols.data() + m_rhsStart[i]; }
+    const SymbolId* rhsEnd(std::size_t i) const { return m_symbols.data() + m_offsets[i + 1]; }
+    std::size_t lhsSize(std::size_t i) const { return m_rhsStart[i] - m_offsets[i]; }
+    std::size_t rhsSize(std::size_t i) const { return m_offsets[i + 1] - m_rhsStart[i]; }
+
+private:
+    template <class It>
+    void append(It lhsBegin, It lhsEnd, It rhsBegin, It rhsEnd);
+
+    std::vector<SymbolId> m_symbols{};
+    std::vector<std::uint32_t> m_offsets{0};
+    std::vector<std::uint32_t> m_rhsStart{};
+};
+
 
 class Grammar
 {
 public:
     Grammar(std::set<Symbol> terminals, std::set<Symbol> nonterminals,
             Symbol start, std::vector<Production> productions);
+    // id-based form used by FiniteAutomaton::toGrammar; every id must belong to `symbols`
+    Grammar(std::shared_ptr<const SymbolTable> symbols, std::vector<SymbolId> terminals,
+            std::vector<SymbolId> nonterminals, SymbolId start, ProductionList productions);
     void print() const;
+    // built once per distinct grammar and shared through GrammarCache::shared(),
+    // so one Grammar can be used from several threads
     const FiniteAutomaton& toFiniteAutomaton() const;
+    // minimal DFA of toFiniteAutomaton() with its compiled table, cached the same way
+    const FiniteAutomaton& toMatcher() const;
+    // hash of the symbol names, the start symbol and the sorted productions
+    std::uint64_t contentHash() const;
+    // prints one random accepted word of toFiniteAutomaton()
     void generateWord() const;
+    // reproducible bulk generation over the same automaton
+    WordGenerator wordGenerator(std::uint64_t seed = 0) const;
 
     //============LAB 2==============
     void classifyGrammar() const;
@@ -34,16 +76,26 @@ public:
 
 private:
     // member variables
-    std::set<Symbol> m_terminals{};
-    std::set<Symbol> m_nonterminals{};
-    Symbol m_start{};
-    std::vector<Production> m_productions{};
+    std::shared_ptr<const SymbolTable> m_symbols{};
+    std::vector<SymbolId> m_terminals{};      // sorted by name
+    std::vector<SymbolId> m_nonterminals{};   // sorted by name
+    SymbolId m_start{SymbolTable::EPSILON};
+    ProductionList m_productions{};
+    std::vector<std::uint8_t> m_kind{};       // per symbol id: TERMINAL | NONTERMINAL bits
+
+    // set once on first use, through std::atomic_load / std::atomic_compare_exchange_strong
+    mutable std::shared_ptr<GrammarCache::Entry> m_cache{};
 
-    mutable bool m_faGenerated{false};       // tracks if FA is already generated
-    mutable FiniteAutomaton m_cachedFA{};    // stores the automaton
+    static constexpr std::uint8_t TERMINAL{1};
+    static constexpr std::uint8_t NONTERMINAL{2};
 
     // member functions
+    void index();
+    bool isTerminal(SymbolId id) const { return m_kind[id] & TERMINAL; }
+    bool isNonterminal(SymbolId id) const { return m_kind[id] & NONTERMINAL; }
     FiniteAutomaton getFiniteAutomaton() const;
+    std::string canonicalForm() const;
+    GrammarCache::Entry& cacheEntry() const;
 };
 
 
@@ -0,0 +1,35 @@
+#include "grammarCache.h"
+
+GrammarCache& GrammarCache::shared()
+{
+    static GrammarCache cache {};
+    return cache;
+}
+
+std::shared_ptr<GrammarCache::Entry> GrammarCache::find(std::uint64_t hash, const std::string& content)
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    for (auto [it, end] = m_entries.equal_range(hash); it != end; ++it)
+        if (auto entry = it->second.lock(); entry && entry->content == content)
+            return entry;
+
+    if (m_entries.size() >= m_nextSweep)
+    {
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+            it = it->second.expired() ? m_entries.erase(it) : std::next(it);
+        m_nextSweep = 2 * m_entries.size() + 16;
+    }
+    auto entry = std::make_shared<Entry>();
+    entry->content = content;
+    m_entries.emplace(hash, entry);
+    return entry;
+}
+
+std::size_t GrammarCache::size() const
+{
+    std::lock_guard<std::mutex> lock {m_mutex};
+    std::size_t live {0};
+    for (const auto& [hash, entry] : m_entries)
+        live += !entry.expired();
+    return live;
+}
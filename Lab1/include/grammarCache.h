@@ -0,0 +1,45 @@
+#ifndef GRAMMAR_CACHE_H
+#define GRAMMAR_CACHE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "finiteAutomaton.h"
+
+// Process-wide cache of what grammars compile to, keyed by a hash of their
+// content, so equal grammars built by different components share one
+// automaton and one compiled matcher. An entry lives as long as some grammar
+// holds it. Each artifact is built at most once, under its own std::once_flag,
+// so concurrent first uses from many threads wait for a single build; a build
+// that throws leaves the artifact unbuilt for the next caller.
+class GrammarCache
+{
+public:
+    struct Entry
+    {
+        std::string content {};          // canonical form, guards against hash collisions
+        std::once_flag automatonOnce {};
+        FiniteAutomaton automaton {};    // states named after the nonterminals
+        std::once_flag matcherOnce {};
+        FiniteAutomaton matcher {};      // minimal DFA with its compiled table
+    };
+
+    static GrammarCache& shared();
+
+    // the live entry for `content`, or a new unbuilt one
+    std::shared_ptr<Entry> find(std::uint64_t hash, const std::string& content);
+
+    //getters
+    // entries still held by some grammar
+    std::size_t size() const;
+
+private:
+    mutable std::mutex m_mutex {};
+    std::unordered_multimap<std::uint64_t, std::weak_ptr<Entry>> m_entries {};
+    std::size_t m_nextSweep {16};  // expired entries are dropped when the map reaches this size
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "languageInclusion.h"
+#include "denseNFA.h"
+#include <algorithm>
+#include <deque>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    constexpr std::uint32_t NONE {~std::uint32_t{0}};
+
+    // union of both symbol lists by name; a[i] / b[i] is the symbol index of
+    // names[i] in each automaton, or NONE when it has no such symbol
+    struct SharedAlphabet
+    {
+        SharedAlphabet(const DenseNFA& x, const DenseNFA& y)
+        {
+            std::size_t i {0}, j {0};
+            while (i < x.symbols.size() || j < y.symbols.size())
+            {
+                const bool fromX {j == y.symbols.size() || (i < x.symbols.size() && x.symbols[i] <= y.symbols[j])};
+                const bool fromY {i == x.symbols.size() || (j < y.symbols.size() && y.symbols[j] <= x.symbols[i])};
+                names.push_back(fromX ? x.symbols[i] : y.symbols[j]);
+                a.push_back(fromX ? static_cast<std::uint32_t>(i++) : NONE);
+                b.push_back(fromY ? static_cast<std::uint32_t>(j++) : NONE);
+            }
+        }
+
+        std::vector<std::string> names {};
+        std::vector<std::uint32_t> a {};
+        std::vector<std::uint32_t> b {};
+    };
+
+    // search tree node; the word to it is read back through the parents
+    struct Node
+    {
+        std::uint32_t parent;
+        std::uint32_t symbol;  // SharedAlphabet index
+    };
+
+    std::string wordTo(const std::vector<Node>& nodes, std::uint32_t id, const SharedAlphabet& sigma)
+    {
+        std::vector<std::uint32_t> symbols {};
+        for (; nodes[id].parent != NONE; id = nodes[id].parent)
+            symbols.push_back(nodes[id].symbol);
+        std::string word {};
+        for (auto it = symbols.rbegin(); it != symbols.rend(); ++it)
+            word += sigma.names[*it];
+        return word;
+    }
+
+    bool bit(const std::vector<std::uint64_t>& bits, std::size_t i)
+    {
+        return (bits[i / 64] >> (i % 64)) & 1U;
+    }
+
+    // deterministic view: state n is the sink every missing move goes to
+    std::uint32_t startOf(const DenseNFA& d)
+    {
+        for (std::size_t s = 0; s < d.stateCount(); ++s)
+            if (bit(d.start, s))
+                return static_cast<std::uint32_t>(s);
+        return static_cast<std::uint32_t>(d.stateCount());
+    }
+    std::uint32_t stepOf(const DenseNFA& d, std::uint32_t symbol, std::uint32_t s)
+    {
+        if (symbol == NONE || s == d.stateCount() || d.succBegin(symbol, s) == d.succEnd(symbol, s))
+            return static_cast<std::uint32_t>(d.stateCount());
+        return *d.succBegin(symbol, s);
+    }
+    bool acceptsIn(const DenseNFA& d, std::uint32_t s)
+    {
+        return s != d.stateCount() && bit(d.finals, s);
+    }
+}
+
+std::optional<std::string> shortestExcess(const DenseNFA& a, const DenseNFA& b)
+{
+    const SharedAlphabet sigma {a, b};
+    const std::vector<std::uint64_t> live {a.liveStates()};
+    const std::size_t words {b.words};
+
+    // node i pairs state[i] of a with the set pool[i * words ..] of b. The
+    // antichain keeps, per state of a, node ids bucketed by set size: only a
+    // smaller set can be a strict subset, and equal sets are found by hash.
+    std::vector<Node> nodes {};
+    std::vector<std::uint32_t> state {};
+    std::vector<std::uint64_t> pool {};
+    std::vector<std::vector<std::vector<std::uint32_t>>> antichain(a.stateCount());
+    std::unordered_multimap<std::uint64_t, std::uint32_t> exact {};
+    auto hashOf = [&](std::uint32_t p, const std::uint64_t* set) {
+        std::uint64_t h {p * 0x9E3779B97F4A7C15ULL};
+        for (std::size_t w = 0; w < words; ++w)
+            h = (h ^ set[w]) * 0x100000001B3ULL;
+        return h;
+    };
+    auto sizeOf = [&](const std::uint64_t* set) {
+        std::size_t count {0};
+        for (std::size_t w = 0; w < words; ++w)
+            count += static_cast<std::size_t>(__builtin_popcountll(set[w]));
+        return count;
+    };
+    auto subsumed = [&](std::uint32_t p, const std::uint64_t* set, std::uint64_t hash, std::size_t size) {
+        for (auto [it, end] = exact.equal_range(hash); it != end; ++it)
+            if (state[it->second] == p && std::equal(set, set + words, pool.data() + std::size_t{it->second} * words))
+                return true;
+        for (std::size_t smaller = 0; smaller < std::min(size, antichain[p].size()); ++smaller)
+            for (std::uint32_t id : antichain[p][smaller])
+            {
+                const std::uint64_t* kept {pool.data() + std::size_t{id} * words};
+                std::size_t w {0};
+                while (w < words && (kept[w] & ~set[w]) == 0)
+                    ++w;
+                if (w == words)
+                    return true;
+            }
+        return false;
+    };
+    // false when the pair is a counterexample; `id` is then its node
+    std::uint32_t id {NONE};
+    auto visit = [&](std::uint32_t p, const std::uint64_t* set, Node from) {
+        if (!bit(live, p))
+            return true;
+        const std::uint64_t hash {hashOf(p, set)};
+        const std::size_t size {sizeOf(set)};
+        if (subsumed(p, set, hash, size))
+            return true;
+        id = static_cast<std::uint32_t>(nodes.size());
+        nodes.push_back(from);
+        state.push_back(p);
+        pool.insert(pool.end(), set, set + words);
+        if (antichain[p].size() <= size)
+            antichain[p].resize(size + 1);
+        antichain[p][size].push_back(id);
+        exact.emplace(hash, id);
+        return !(bit(a.finals, p) && !b.intersectsFinals({set, 0, static_cast<std::uint32_t>(words)}));
+    };
+
+    for (std::uint32_t p = 0; p < a.stateCount(); ++p)
+        if (bit(a.start, p) && !visit(p, b.start.data(), {NONE, NONE}))
+            return wordTo(nodes, id, sigma);
+
+    std::vector<std::uint64_t> next(words, 0);
+    for (std::uint32_t head = 0; head < nodes.size(); ++head)
+        for (std::uint32_t u = 0; u < sigma.names.size(); ++u)
+        {
+            if (sigma.a[u] == NONE)
+                continue;
+            const std::uint32_t p {state[head]};
+            if (a.succBegin(sigma.a[u], p) == a.succEnd(sigma.a[u], p))
+                continue;
+            std::fill(next.begin(), next.end(), 0);
+            if (sigma.b[u] != NONE)
+                b.move({pool.data() + std::size_t{head} * words, 0, static_cast<std::uint32_t>(words)}, sigma.b[u], next.data());
+            // pool may move while visiting, so the successors are read first
+            const std::vector<std::uint32_t> targets(a.succBegin(sigma.a[u], p), a.succEnd(sigma.a[u], p));
+            for (std::uint32_t t : targets)
+                if (!visit(t, next.data(), {head, u}))
+                    return wordTo(nodes, id, sigma);
+        }
+    return std::nullopt;
+}
+
+bool equivalentDFAs(const DenseNFA& a, const DenseNFA& b)
+{
+    const SharedAlphabet sigma {a, b};
+    // a's states and sink are 0 .. na, b's follow
+    const std::uint32_t offset {static_cast<std::uint32_t>(a.stateCount() + 1)};
+    std::vector<std::uint32_t> parent(offset + b.stateCount() + 1);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](std::uint32_t x) {
+        while (parent[x] != x)
+            x = parent[x] = parent[parent[x]];
+        return x;
+    };
+
+    std::deque<std::pair<std::uint32_t, std::uint32_t>> work {{startOf(a), startOf(b)}};
+    parent[find(startOf(a))] = find(offset + startOf(b));
+    while (!work.empty())
+    {
+        const auto [p, q] {work.front()};
+        work.pop_front();
+        if (acceptsIn(a, p) != acceptsIn(b, q))
+            return false;
+        for (std::uint32_t u = 0; u < sigma.names.size(); ++u)
+        {
+            const std::uint32_t p2 {stepOf(a, sigma.a[u], p)};
+            const std::uint32_t q2 {stepOf(b, sigma.b[u], q)};
+            const std::uint32_t x {find(p2)};
+            const std::uint32_t y {find(offset + q2)};
+            if (x != y)
+            {
+                parent[x] = y;
+                work.push_back({p2, q2});
+            }
+        }
+    }
+    return true;
+}
+
+std::optional<std::string> shortestDifference(const DenseNFA& a, const DenseNFA& b)
+{
+    const SharedAlphabet sigma {a, b};
+    const std::uint64_t width {b.stateCount() + 1};
+    std::vector<Node> nodes {{NONE, NONE}};
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs {{startOf(a), startOf(b)}};
+    std::unordered_map<std::uint64_t, std::uint32_t> seen {{pairs[0].first * width + pairs[0].second, 0}};
+    for (std::uint32_t head = 0; head < pairs.size(); ++head)
+    {
+        const auto [p, q] {pairs[head]};
+        if (acceptsIn(a, p) != acceptsIn(b, q))
+            return wordTo(nodes, head, sigma);
+        for (std::uint32_t u = 0; u < sigma.names.size(); ++u)
+        {
+            const std::uint32_t p2 {stepOf(a, sigma.a[u], p)};
+            const std::uint32_t q2 {stepOf(b, sigma.b[u], q)};
+            if (seen.emplace(p2 * width + q2, static_cast<std::uint32_t>(pairs.size())).second)
+            {
+                nodes.push_back({head, u});
+                pairs.push_back({p2, q2});
+            }
+        }
+    }
+    return std::nullopt;
+}
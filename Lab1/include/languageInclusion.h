@@ -0,0 +1,28 @@
+#ifndef LANGUAGE_INCLUSION_H
+#define LANGUAGE_INCLUSION_H
+
+#include <optional>
+#include <string>
+
+struct DenseNFA;
+
+// Language comparisons over DenseNFA views of two automata. Symbols are
+// matched by name, so the automata may use different symbol tables; a
+// counterexample is the concatenation of its symbol names.
+
+// Shortest word in L(a) but not in L(b), or nullopt when L(a) ⊆ L(b).
+// Breadth-first search over pairs (state of a, set of states of b) that
+// never determinizes b in full: a pair is dropped when another pair for the
+// same state of a holds a subset of its set (the antichain), since anything
+// the larger set rejects the smaller one rejects too.
+std::optional<std::string> shortestExcess(const DenseNFA& a, const DenseNFA& b);
+
+// Hopcroft–Karp: both automata deterministic, with a missing move going to
+// an implicit sink. State pairs are merged in a union-find and only pairs not
+// already known equivalent are explored, so equal languages take near-linear time.
+bool equivalentDFAs(const DenseNFA& a, const DenseNFA& b);
+// shortest word in exactly one of two deterministic languages, by
+// breadth-first search over the product; nullopt when they are equal
+std::optional<std::string> shortestDifference(const DenseNFA& a, const DenseNFA& b);
+
+#endif
@@ -0,0 +1,110 @@
+#include "lazyDFA.h"
+#include "finiteAutomaton.h"
+#include <algorithm>
+
+LazyDFA::LazyDFA(const FiniteAutomaton& fa, std::size_t cacheBytes)
+    : m_nfa {std::make_shared<const DenseNFA>(fa)}
+    , m_cacheBytes {cacheBytes}
+    , m_subsets {m_nfa->words}
+    , m_scratch(m_nfa->words, 0)
+{
+    // only single-character symbols can be matched byte by byte
+    m_column.fill(-1);
+    for (std::size_t a = 0; a < m_nfa->symbolCount(); ++a)
+    {
+        if (m_nfa->symbols[a].size() != 1)
+            continue;
+        m_column[static_cast<unsigned char>(m_nfa->symbols[a][0])] = static_cast<std::int32_t>(m_columnSymbol.size());
+        m_columnSymbol.push_back(a);
+    }
+}
+
+std::size_t LazyDFA::usedBytes() const
+{
+    // capacities, not sizes: what the cache really holds
+    return m_subsets.bytes() + m_next.capacity() * sizeof(std::int32_t) + m_final.capacity();
+}
+
+std::size_t LazyDFA::bytesAfterInsert() const
+{
+    // as SubsetTable::bytesAfterInsert: vectors are assumed to double when full
+    const std::size_t columns {m_columnSymbol.size()};
+    auto grown = [](std::size_t size, std::size_t capacity, std::size_t added) {
+        return size + added <= capacity ? capacity : std::max(2 * capacity, size + added);
+    };
+    return m_subsets.bytesAfterInsert(m_nfa->words)
+         + grown(m_next.size(), m_next.capacity(), columns) * sizeof(std::int32_t)
+         + grown(m_final.size(), m_final.capacity(), 1);
+}
+
+LazyDFA::Stats LazyDFA::stats() const
+{
+    Stats s {m_stats};
+    s.states = m_subsets.size();
+    s.bytes = usedBytes();
+    return s;
+}
+
+void LazyDFA::flush()
+{
+    // release the storage too, so the budget bounds what is held after a flush
+    m_subsets.clear();
+    std::vector<std::int32_t> {}.swap(m_next);
+    std::vector<std::uint8_t> {}.swap(m_final);
+    ++m_stats.flushes;
+}
+
+std::size_t LazyDFA::addState(const std::uint64_t* set)
+{
+    std::size_t id {m_subsets.find(set)};
+    if (id != SubsetTable::NPOS)
+        return id;
+    // the new state would not fit, counting the growth it may trigger: start
+    // over with an empty cache. A state is always admitted into an empty cache
+    // so matching can progress.
+    if (m_subsets.size() > 0 && bytesAfterInsert() > m_cacheBytes)
+        flush();
+    id = m_subsets.insert(set);
+    m_next.resize(m_next.size() + m_columnSymbol.size(), UNKNOWN);
+    m_final.push_back(m_nfa->intersectsFinals(m_subsets.view(id)));
+    return id;
+}
+
+// fills in the transition of `state` on `column`; returns the target, or DEAD
+std::int32_t LazyDFA::computeNext(std::size_t state, std::size_t column)
+{
+    ++m_stats.misses;
+    if (!m_nfa->move(m_subsets.view(state), m_columnSymbol[column], m_scratch.data()))
+    {
+        m_next[state * m_columnSymbol.size() + column] = DEAD;
+        return DEAD;
+    }
+    const std::uint64_t flushesBefore {m_stats.flushes};
+    const std::size_t target {addState(m_scratch.data())};
+    std::fill(m_scratch.begin(), m_scratch.end(), 0);
+    // after a flush `state` no longer exists, so there is no edge to record
+    if (m_stats.flushes == flushesBefore)
+        m_next[state * m_columnSymbol.size() + column] = static_cast<std::int32_t>(target);
+    return static_cast<std::int32_t>(target);
+}
+
+bool LazyDFA::matches(std::string_view input)
+{
+    std::size_t state {addState(m_nfa->start.data())};
+    const std::size_t columns {m_columnSymbol.size()};
+    for (unsigned char c : input)
+    {
+        const std::int32_t column {m_column[c]};
+        if (column < 0)
+            return false;
+        std::int32_t next {m_next[state * columns + column]};
+        if (next == UNKNOWN)
+            next = computeNext(state, static_cast<std::size_t>(column));
+        else
+            ++m_stats.hits;
+        if (next == DEAD)
+            return false;
+        state = static_cast<std::size_t>(next);
+    }
+    return m_final[state] != 0;
+}
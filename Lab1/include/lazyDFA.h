@@ -0,0 +1,63 @@
+#ifndef LAZY_DFA_H
+#define LAZY_DFA_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "denseNFA.h"
+
+class FiniteAutomaton;
+
+// On-the-fly determinization: DFA states are built the first time matching
+// reaches them and cached until the cache outgrows its memory budget, at
+// which point the whole cache is flushed, its storage freed, and matching
+// carries on from the current subset (the same strategy as RE2's DFA). The
+// budget counts allocated capacity, including the growth the next state would
+// cause, so only a single state too big for it can push past. Matching mutates the
+// cache, so each thread should use its own LazyDFA; copies share the NFA.
+class LazyDFA
+{
+public:
+    struct Stats
+    {
+        std::uint64_t hits {0};     // transitions found in the cache
+        std::uint64_t misses {0};   // transitions computed from the NFA
+        std::uint64_t flushes {0};  // times the cache was emptied
+        std::size_t states {0};     // DFA states cached right now
+        std::size_t bytes {0};      // memory held by the cache right now
+    };
+
+    LazyDFA(const FiniteAutomaton& fa, std::size_t cacheBytes);
+
+    bool matches(std::string_view input);
+
+    Stats stats() const;
+    void resetStats() { m_stats = {}; }
+    std::size_t cacheBytes() const { return m_cacheBytes; }
+
+private:
+    static constexpr std::int32_t UNKNOWN {-1};
+    static constexpr std::int32_t DEAD {-2};
+
+    std::size_t addState(const std::uint64_t* set);
+    std::int32_t computeNext(std::size_t state, std::size_t column);
+    void flush();
+    std::size_t usedBytes() const;
+    std::size_t bytesAfterInsert() const;
+
+    std::shared_ptr<const DenseNFA> m_nfa {};
+    std::array<std::int32_t, 256> m_column {}; // byte -> symbol column, -1 if unused
+    std::vector<std::size_t> m_columnSymbol {}; // column -> DenseNFA symbol
+    std::size_t m_cacheBytes {0};
+
+    SubsetTable m_subsets;
+    std::vector<std::int32_t> m_next {};      // state * columns + column
+    std::vector<std::uint8_t> m_final {};
+    std::vector<std::uint64_t> m_scratch {};
+    Stats m_stats {};
+};
+
+#endif
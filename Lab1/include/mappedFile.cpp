@@ -0,0 +1,81 @@
+#include "mappedFile.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LFA_HAVE_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+{
+#ifdef LFA_HAVE_MMAP
+    int fd {::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    struct stat st {};
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("MappedFile: cannot stat " + path);
+    }
+    m_size = static_cast<std::size_t>(st.st_size);
+    if (m_size > 0)
+    {
+        void* p {::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0)};
+        ::close(fd);
+        if (p == MAP_FAILED)
+            throw std::runtime_error("MappedFile: cannot map " + path);
+        m_data = static_cast<const char*>(p);
+        m_mapped = true;
+        return;
+    }
+    ::close(fd);
+#else
+    std::ifstream in {path, std::ios::binary};
+    if (!in)
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    m_fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    m_size = m_fallback.size();
+#endif
+    m_data = m_fallback.data();
+}
+
+MappedFile::~MappedFile()
+{
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+    release();
+    m_mapped = std::exchange(other.m_mapped, false);
+    m_size = std::exchange(other.m_size, 0);
+    m_fallback = std::move(other.m_fallback);
+    m_data = m_mapped ? std::exchange(other.m_data, nullptr) : m_fallback.data();
+    other.m_data = nullptr;
+    return *this;
+}
+
+void MappedFile::release()
+{
+#ifdef LFA_HAVE_MMAP
+    if (m_mapped)
+        ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+    m_mapped = false;
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file. On POSIX systems the file is memory-mapped,
+// so its pages come straight from (and are shared through) the page cache;
+// elsewhere it is read into memory. Throws std::runtime_error if it cannot be opened.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    std::string_view view() const { return {m_data, m_size}; }
+    const char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+private:
+    void release();
+
+    const char* m_data {nullptr};
+    std::size_t m_size {0};
+    bool m_mapped {false};
+    std::string m_fallback {};   // owns the bytes when mapping is unavailable
+};
+
+#endif
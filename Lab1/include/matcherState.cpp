@@ -0,0 +1,73 @@
+#include "matcherState.h"
+#include "bitParallelNFA.h"
+#include "packedDFA.h"
+
+MatcherState::MatcherState(std::shared_ptr<const CompiledDFA> dfa, std::shared_ptr<const BitParallelNFA> nfa,
+                           std::shared_ptr<const PackedDFA> packed)
+    : m_dfa {std::move(dfa)}
+    , m_nfa {std::move(nfa)}
+    , m_packed {std::move(packed)}
+{
+    if (m_nfa)
+    {
+        m_active.resize(m_nfa->words());
+        m_scratch.resize(m_nfa->words());
+    }
+    reset();
+}
+
+void MatcherState::reset()
+{
+    m_consumed = 0;
+    if (m_dfa)
+    {
+        m_state = m_dfa->startState();
+        m_dead = m_state == CompiledDFA::DEAD;
+        return;
+    }
+    if (m_packed)
+    {
+        m_state = m_packed->startState();
+        m_dead = m_state == PackedDFA::DEAD;
+        return;
+    }
+    if (m_nfa && m_nfa->stateCount() > 0)
+    {
+        m_nfa->reset(m_active.data());
+        // an empty chunk only reports whether the start set is alive
+        m_dead = !m_nfa->advance(m_active.data(), m_scratch.data(), {});
+        return;
+    }
+    m_dead = true;
+}
+
+void MatcherState::feed(std::string_view chunk)
+{
+    m_consumed += chunk.size();
+    if (m_dead)
+        return;
+    if (m_dfa)
+    {
+        m_state = m_dfa->advance(m_state, chunk);
+        m_dead = m_state == CompiledDFA::DEAD;
+        return;
+    }
+    if (m_packed)
+    {
+        m_state = m_packed->advance(m_state, chunk);
+        m_dead = m_state == PackedDFA::DEAD;
+        return;
+    }
+    m_dead = !m_nfa->advance(m_active.data(), m_scratch.data(), chunk);
+}
+
+bool MatcherState::isAccepting() const
+{
+    if (m_dead)
+        return false;
+    if (m_dfa)
+        return m_dfa->isFinal(m_state);
+    if (m_packed)
+        return m_packed->isFinal(m_state);
+    return m_nfa->accepts(m_active.data());
+}
@@ -0,0 +1,42 @@
+#ifndef MATCHER_STATE_H
+#define MATCHER_STATE_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "compiledDFA.h"
+
+class BitParallelNFA;
+class PackedDFA;
+
+// Resumable membership test: input is fed in chunks of any size and only the
+// current state (a DFA row or an NFA active set) is kept between calls, so
+// memory does not grow with the input. Obtain one from FiniteAutomaton::matcher().
+class MatcherState
+{
+public:
+    MatcherState(std::shared_ptr<const CompiledDFA> dfa, std::shared_ptr<const BitParallelNFA> nfa,
+                 std::shared_ptr<const PackedDFA> packed = {});
+
+    void feed(std::string_view chunk);
+    // true if everything fed so far is a word of the language
+    bool isAccepting() const;
+    // true once no continuation can be accepted; further input can be skipped
+    bool isDead() const { return m_dead; }
+    void reset();
+
+    std::uint64_t bytesConsumed() const { return m_consumed; }
+
+private:
+    std::shared_ptr<const CompiledDFA> m_dfa {};
+    std::shared_ptr<const BitParallelNFA> m_nfa {};
+    std::shared_ptr<const PackedDFA> m_packed {};
+    CompiledDFA::StateId m_state {CompiledDFA::DEAD};  // a row, or a PackedDFA state index
+    std::vector<std::uint64_t> m_active {};
+    std::vector<std::uint64_t> m_scratch {};
+    std::uint64_t m_consumed {0};
+    bool m_dead {true};
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include "nfaReduction.h"
+#include "denseNFA.h"
+#include <algorithm>
+#include <tuple>
+
+NFAReducer::NFAReducer(const DenseNFA& nfa)
+    : m_states {nfa.stateCount()}
+    , m_initial(nfa.stateCount(), 0)
+    , m_final(nfa.stateCount(), 0)
+{
+    for (std::size_t q = 0; q < m_states; ++q)
+    {
+        m_initial[q] = (nfa.start[q / 64] >> (q % 64)) & 1U;
+        m_final[q] = (nfa.finals[q / 64] >> (q % 64)) & 1U;
+        for (std::size_t a = 0; a < nfa.symbolCount(); ++a)
+            for (const std::uint32_t* t = nfa.succBegin(a, q); t != nfa.succEnd(a, q); ++t)
+                m_edges.push_back({static_cast<std::uint32_t>(q), static_cast<std::uint32_t>(a), *t});
+    }
+    normalize();
+}
+
+void NFAReducer::normalize()
+{
+    std::sort(m_edges.begin(), m_edges.end(), [](const Edge& x, const Edge& y) {
+        return std::tie(x.from, x.symbol, x.to) < std::tie(y.from, y.symbol, y.to);
+    });
+    m_edges.erase(std::unique(m_edges.begin(), m_edges.end(), [](const Edge& x, const Edge& y) {
+        return x.from == y.from && x.symbol == y.symbol && x.to == y.to;
+    }), m_edges.end());
+}
+
+void NFAReducer::quotient(const std::vector<std::uint32_t>& block, std::size_t count)
+{
+    std::vector<std::uint8_t> initial(count, 0);
+    std::vector<std::uint8_t> final(count, 0);
+    for (std::size_t q = 0; q < m_states; ++q)
+    {
+        initial[block[q]] |= m_initial[q];
+        final[block[q]] |= m_final[q];
+    }
+    for (auto& e : m_edges)
+    {
+        e.from = block[e.from];
+        e.to = block[e.to];
+    }
+    m_states = count;
+    m_initial = std::move(initial);
+    m_final = std::move(final);
+    normalize();
+}
+
+void NFAReducer::trim()
+{
+    std::vector<std::vector<std::uint32_t>> forward(m_states), backward(m_states);
+    for (const auto& e : m_edges)
+    {
+        forward[e.from].push_back(e.to);
+        backward[e.to].push_back(e.from);
+    }
+    auto search = [&](const std::vector<std::uint8_t>& seeds, const std::vector<std::vector<std::uint32_t>>& next) {
+        std::vector<std::uint8_t> seen(seeds);
+        std::vector<std::uint32_t> stack {};
+        for (std::uint32_t q = 0; q < m_states; ++q)
+            if (seen[q])
+                stack.push_back(q);
+        while (!stack.empty())
+        {
+            const std::uint32_t q {stack.back()};
+            stack.pop_back();
+            for (std::uint32_t t : next[q])
+                if (!seen[t])
+                {
+                    seen[t] = 1;
+                    stack.push_back(t);
+                }
+        }
+        return seen;
+    };
+    const std::vector<std::uint8_t> reachable {search(m_initial, forward)};
+    const std::vector<std::uint8_t> live {search(m_final, backward)};
+
+    std::vector<std::uint32_t> index(m_states, 0);
+    std::size_t count {0};
+    for (std::size_t q = 0; q < m_states; ++q)
+        if (reachable[q] && live[q])
+            index[q] = static_cast<std::uint32_t>(count++);
+    std::vector<Edge> edges {};
+    for (const auto& e : m_edges)
+        if (reachable[e.from] && live[e.from] && reachable[e.to] && live[e.to])
+            edges.push_back({index[e.from], e.symbol, index[e.to]});
+    std::vector<std::uint8_t> initial(count, 0), final(count, 0);
+    for (std::size_t q = 0; q < m_states; ++q)
+        if (reachable[q] && live[q])
+        {
+            initial[index[q]] = m_initial[q];
+            final[index[q]] = m_final[q];
+        }
+    m_states = count;
+    m_edges = std::move(edges);
+    m_initial = std::move(initial);
+    m_final = std::move(final);
+}
+
+void NFAReducer::mergeBisimilar(bool backward)
+{
+    // forward: the coarsest partition with blocks of one finality where, for every
+    // symbol a and block B, either all or none of a block's states have an a-edge
+    // into B; backward: the same with initiality and edges reversed. Paige–Tarjan:
+    // blocks are split against compound blocks, always by the smaller half.
+    const std::size_t n {m_states};
+    if (n == 0)
+        return;
+    std::vector<Edge> edges {m_edges};
+    if (backward)
+        for (auto& e : edges)
+            std::swap(e.from, e.to);
+    std::sort(edges.begin(), edges.end(), [](const Edge& x, const Edge& y) {
+        return std::tie(x.from, x.symbol) < std::tie(y.from, y.symbol);
+    });
+
+    // count[cell[e]]: edges from e.from on e.symbol into the compound holding e.to
+    std::vector<std::uint32_t> cell(edges.size(), 0);
+    std::vector<std::uint32_t> count {};
+    for (std::size_t i = 0; i < edges.size(); ++i)
+    {
+        if (i == 0 || edges[i].from != edges[i - 1].from || edges[i].symbol != edges[i - 1].symbol)
+            count.push_back(0);
+        cell[i] = static_cast<std::uint32_t>(count.size() - 1);
+        ++count.back();
+    }
+    std::vector<std::uint32_t> inBegin(n + 1, 0);
+    for (const auto& e : edges)
+        ++inBegin[e.to + 1];
+    for (std::size_t q = 0; q < n; ++q)
+        inBegin[q + 1] += inBegin[q];
+    std::vector<std::uint32_t> in(edges.size(), 0);
+    {
+        std::vector<std::uint32_t> fill(inBegin.begin(), inBegin.end() - 1);
+        for (std::size_t i = 0; i < edges.size(); ++i)
+            in[fill[edges[i].to]++] = static_cast<std::uint32_t>(i);
+    }
+
+    // blocks are ranges [first, last) of elems; marked states are swapped to the front.
+    // A compound is a set of blocks the partition is already stable against as a whole.
+    std::vector<std::uint32_t> elems(n, 0), loc(n, 0), blockOf(n, 0);
+    std::vector<std::uint32_t> first {}, last {}, marked {}, compoundOf {};
+    std::vector<std::vector<std::uint32_t>> compounds(1);
+    std::vector<std::uint32_t> work {};  // compounds of more than one block
+    {
+        const std::vector<std::uint8_t>& flag {backward ? m_initial : m_final};
+        std::size_t pos {0};
+        for (std::uint8_t value : {0, 1})
+        {
+            const std::size_t begin {pos};
+            for (std::uint32_t q = 0; q < n; ++q)
+                if (flag[q] == value)
+                {
+                    elems[pos] = q;
+                    loc[q] = static_cast<std::uint32_t>(pos++);
+                    blockOf[q] = static_cast<std::uint32_t>(first.size());
+                }
+            if (pos == begin)
+                continue;
+            compounds[0].push_back(static_cast<std::uint32_t>(first.size()));
+            first.push_back(static_cast<std::uint32_t>(begin));
+            last.push_back(static_cast<std::uint32_t>(pos));
+            marked.push_back(0);
+            compoundOf.push_back(0);
+        }
+        if (compounds[0].size() > 1)
+            work.push_back(0);
+    }
+
+    std::vector<std::uint32_t> touched {};
+    auto mark = [&](std::uint32_t q) {
+        const std::uint32_t b {blockOf[q]};
+        if (loc[q] < first[b] + marked[b])
+            return;
+        if (marked[b] == 0)
+            touched.push_back(b);
+        const std::uint32_t dst {first[b] + marked[b]++};
+        const std::uint32_t other {elems[dst]};
+        std::swap(elems[dst], elems[loc[q]]);
+        loc[other] = loc[q];
+        loc[q] = dst;
+    };
+    // the marked prefix of every touched block becomes a block of the same compound
+    auto split = [&]() {
+        for (std::uint32_t b : touched)
+        {
+            const std::uint32_t m {marked[b]};
+            marked[b] = 0;
+            if (m == last[b] - first[b])
+                continue;
+            const auto nb {static_cast<std::uint32_t>(first.size())};
+            first.push_back(first[b]);
+            last.push_back(first[b] + m);
+            marked.push_back(0);
+            first[b] += m;
+            for (std::uint32_t i = first[nb]; i < last[nb]; ++i)
+                blockOf[elems[i]] = nb;
+            auto& compound {compounds[compoundOf[b]]};
+            compoundOf.push_back(compoundOf[b]);
+            compound.push_back(nb);
+            if (compound.size() == 2)
+                work.push_back(compoundOf[b]);
+        }
+        touched.clear();
+    };
+
+    // stable against the whole state set: split by having an edge on each symbol
+    {
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> sources {};
+        for (std::size_t i = 0; i < edges.size(); ++i)
+            sources.push_back({edges[i].symbol, edges[i].from});
+        std::sort(sources.begin(), sources.end());
+        for (std::size_t i = 0; i < sources.size(); ++i)
+        {
+            mark(sources[i].second);
+            if (i + 1 == sources.size() || sources[i + 1].first != sources[i].first)
+                split();
+        }
+    }
+
+    constexpr std::uint32_t NONE {~0U};
+    std::vector<std::uint32_t> fresh(n, NONE);  // cell of (source, symbol, splitter)
+    std::vector<std::uint32_t> splitter {};
+    while (!work.empty())
+    {
+        // take out the smaller of two blocks of a compound, so at most half of it
+        const std::uint32_t from {work.back()};
+        std::vector<std::uint32_t>& compound {compounds[from]};
+        const std::size_t pick {last[compound[0]] - first[compound[0]] <= last[compound[1]] - first[compound[1]] ? 0U : 1U};
+        const std::uint32_t b {compound[pick]};
+        compound[pick] = compound.back();
+        compound.pop_back();
+        if (compound.size() == 1)
+            work.pop_back();
+        compoundOf[b] = static_cast<std::uint32_t>(compounds.size());
+        compounds.push_back({b});
+
+        splitter.clear();
+        for (std::uint32_t i = first[b]; i < last[b]; ++i)
+            splitter.insert(splitter.end(), in.begin() + inBegin[elems[i]], in.begin() + inBegin[elems[i] + 1]);
+        std::sort(splitter.begin(), splitter.end(), [&](std::uint32_t x, std::uint32_t y) {
+            return edges[x].symbol < edges[y].symbol;
+        });
+        for (std::size_t g = 0, h = 0; g < splitter.size(); g = h)
+        {
+            while (h < splitter.size() && edges[splitter[h]].symbol == edges[splitter[g]].symbol)
+                ++h;
+            // sources with an edge into b, then those of them with none into the rest of the compound
+            for (std::size_t i = g; i < h; ++i)
+            {
+                const std::uint32_t q {edges[splitter[i]].from};
+                if (fresh[q] == NONE)
+                {
+                    fresh[q] = static_cast<std::uint32_t>(count.size());
+                    count.push_back(0);
+                    mark(q);
+                }
+                ++count[fresh[q]];
+            }
+            split();
+            for (std::size_t i = g; i < h; ++i)
+            {
+                const std::uint32_t q {edges[splitter[i]].from};
+                if (count[fresh[q]] == count[cell[splitter[i]]])
+                    mark(q);
+            }
+            split();
+            for (std::size_t i = g; i < h; ++i)
+            {
+                --count[cell[splitter[i]]];
+                cell[splitter[i]] = fresh[edges[splitter[i]].from];
+            }
+            for (std::size_t i = g; i < h; ++i)
+                fresh[edges[splitter[i]].from] = NONE;
+        }
+    }
+
+    // number the blocks in order of their first state
+    std::vector<std::uint32_t> number(first.size(), NONE);
+    std::vector<std::uint32_t> block(n, 0);
+    std::size_t blocks {0};
+    for (std::size_t q = 0; q < n; ++q)
+    {
+        if (number[blockOf[q]] == NONE)
+            number[blockOf[q]] = static_cast<std::uint32_t>(blocks++);
+        block[q] = number[blockOf[q]];
+    }
+    if (blocks < n)
+        quotient(block, blocks);
+}
+
+std::size_t NFAReducer::applySimulation(std::size_t limit)
+{
+    if (m_states == 0 || m_states > limit)
+        return 0;
+    const std::size_t n {m_states};
+    const std::size_t words {(n + 63) / 64};
+
+    // rows of edges by source, edges sorted by (from, symbol, to)
+    std::vector<std::uint32_t> rowBegin(n + 1, 0);
+    for (const auto& e : m_edges)
+        ++rowBegin[e.from + 1];
+    for (std::size_t q = 0; q < n; ++q)
+        rowBegin[q + 1] += rowBegin[q];
+
+    // sim[q] has bit p when p simulates q
+    std::vector<std::uint64_t> sim(n * words, 0);
+    auto simulates = [&](std::size_t q, std::size_t p) { return (sim[q * words + p / 64] >> (p % 64)) & 1U; };
+    for (std::size_t q = 0; q < n; ++q)
+        for (std::size_t p = 0; p < n; ++p)
+            if (!m_final[q] || m_final[p])
+                sim[q * words + p / 64] |= std::uint64_t{1} << (p % 64);
+
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (std::size_t q = 0; q < n; ++q)
+            for (std::size_t p = 0; p < n; ++p)
+            {
+                if (p == q || !simulates(q, p))
+                    continue;
+                // every q -a-> q' needs some p -a-> p' with p' simulating q'
+                bool holds {true};
+                std::uint32_t j {rowBegin[p]};
+                for (std::uint32_t i = rowBegin[q]; i < rowBegin[q + 1] && holds; ++i)
+                {
+                    const Edge& mine {m_edges[i]};
+                    while (j < rowBegin[p + 1] && m_edges[j].symbol < mine.symbol)
+                        ++j;
+                    holds = false;
+                    for (std::uint32_t k = j; k < rowBegin[p + 1] && m_edges[k].symbol == mine.symbol && !holds; ++k)
+                        holds = simulates(mine.to, m_edges[k].to);
+                }
+                if (!holds)
+                {
+                    sim[q * words + p / 64] &= ~(std::uint64_t{1} << (p % 64));
+                    changed = true;
+                }
+            }
+    }
+
+    // merge simulation-equivalent states: each takes the block of the first one equivalent to it
+    std::vector<std::uint32_t> block(n, 0);
+    std::vector<std::uint32_t> representative {};
+    for (std::size_t q = 0; q < n; ++q)
+    {
+        std::size_t b {0};
+        while (b < representative.size() && !(simulates(q, representative[b]) && simulates(representative[b], q)))
+            ++b;
+        if (b == representative.size())
+            representative.push_back(static_cast<std::uint32_t>(q));
+        block[q] = static_cast<std::uint32_t>(b);
+    }
+    const std::size_t count {representative.size()};
+    auto strictlyBelow = [&](std::uint32_t x, std::uint32_t y) {
+        return x != y && simulates(representative[x], representative[y]);
+    };
+    if (count < n)
+        quotient(block, count);
+
+    // little brothers: drop q' when a sibling on the same symbol, or another
+    // initial state, strictly simulates it
+    std::size_t pruned {0};
+    std::vector<Edge> kept {};
+    for (std::size_t i = 0, j = 0; i < m_edges.size(); i = j)
+    {
+        while (j < m_edges.size() && m_edges[j].from == m_edges[i].from && m_edges[j].symbol == m_edges[i].symbol)
+            ++j;
+        for (std::size_t k = i; k < j; ++k)
+        {
+            bool dominated {false};
+            for (std::size_t l = i; l < j && !dominated; ++l)
+                dominated = strictlyBelow(m_edges[k].to, m_edges[l].to);
+            if (dominated)
+                ++pruned;
+            else
+                kept.push_back(m_edges[k]);
+        }
+    }
+    m_edges = std::move(kept);
+    std::vector<std::uint8_t> initial {m_initial};
+    for (std::uint32_t q = 0; q < m_states; ++q)
+        for (std::uint32_t p = 0; p < m_states && initial[q]; ++p)
+            if (m_initial[p] && strictlyBelow(q, p))
+                initial[q] = 0;
+    m_initial = std::move(initial);
+    trim();
+    return pruned;
+}
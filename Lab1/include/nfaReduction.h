@@ -0,0 +1,54 @@
+#ifndef NFA_REDUCTION_H
+#define NFA_REDUCTION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct DenseNFA;
+
+// Epsilon-free NFA with a set of initial states, reduced in place before
+// subset construction. Every step keeps the language:
+//  - trim() drops states that are unreachable or cannot reach a final state;
+//  - mergeBisimilar() merges states with the same future (forward) or the
+//    same past (backward), by Paige–Tarjan partition refinement;
+//  - applySimulation() computes direct forward simulation, merges states that
+//    simulate each other and drops edges to, and initial states that are,
+//    "little brothers": strictly simulated by a sibling on the same symbol.
+//    The relation is a bit matrix, so it only runs up to `limit` states.
+class NFAReducer
+{
+public:
+    struct Edge
+    {
+        std::uint32_t from;
+        std::uint32_t symbol;  // DenseNFA symbol index
+        std::uint32_t to;
+    };
+
+    // states are the DenseNFA's, epsilon closures already folded into its edges
+    explicit NFAReducer(const DenseNFA& nfa);
+
+    void trim();
+    void mergeBisimilar(bool backward);
+    // number of edges pruned
+    std::size_t applySimulation(std::size_t limit);
+
+    //getters
+    std::size_t stateCount() const { return m_states; }
+    const std::vector<Edge>& edges() const { return m_edges; }
+    bool isInitial(std::size_t q) const { return m_initial[q] != 0; }
+    bool isFinal(std::size_t q) const { return m_final[q] != 0; }
+
+private:
+    // merges states by block number; blocks are 0 .. count-1
+    void quotient(const std::vector<std::uint32_t>& block, std::size_t count);
+    void normalize();
+
+    std::size_t m_states {0};
+    std::vector<Edge> m_edges {};       // sorted by (from, symbol, to), no duplicates
+    std::vector<std::uint8_t> m_initial {};
+    std::vector<std::uint8_t> m_final {};
+};
+
+#endif
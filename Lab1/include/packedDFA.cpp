@@ -0,0 +1,205 @@
+#include "packedDFA.h"
+#include "compiledDFA.h"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+PackedDFA::PackedDFA(const CompiledDFA& dfa)
+    : m_base(dfa.stateCount(), 0)
+    , m_default(dfa.stateCount(), DEAD)
+    , m_classCount {dfa.classCount()}
+    , m_start {static_cast<StateId>(dfa.indexOf(dfa.startState()))}
+{
+    const std::size_t n {dfa.stateCount()};
+    const std::size_t width {m_classCount};
+
+    // one representative byte per class to read the dense rows with
+    std::vector<unsigned char> representative(width, 0);
+    for (unsigned c = 256; c-- > 0;)
+    {
+        m_classOf[c] = dfa.classOf(static_cast<unsigned char>(c));
+        representative[m_classOf[c]] = static_cast<unsigned char>(c);
+    }
+    auto target = [&](std::size_t q, std::size_t cls) {
+        return static_cast<StateId>(dfa.indexOf(dfa.next(dfa.rowOf(q), representative[cls])));
+    };
+
+    m_finalBits.assign((n + 63) / 64, 0);
+    for (std::size_t q = 0; q < n; ++q)
+        if (dfa.isFinal(dfa.rowOf(q)))
+            m_finalBits[q / 64] |= std::uint64_t{1} << (q % 64);
+
+    if (n - 1 >= FALLBACK_ROW)
+        throw std::length_error("PackedDFA: too many states");
+
+    // encoding order: breadth-first from the start state, with the tree parent
+    // and the class that leads to each state; unreachable states come last
+    std::vector<std::uint32_t> order {};
+    std::vector<std::uint32_t> parent(n, 0);
+    std::vector<std::uint32_t> via(n, 0);
+    std::vector<bool> seen(n, false);
+    seen[0] = true;
+    if (m_start != DEAD)
+    {
+        seen[m_start] = true;
+        order.push_back(m_start);
+    }
+    for (std::size_t head = 0; head < order.size(); ++head)
+        for (std::size_t cls = 0; cls < width; ++cls)
+        {
+            const StateId t {target(order[head], cls)};
+            if (!seen[t])
+            {
+                seen[t] = true;
+                parent[t] = order[head];
+                via[t] = static_cast<std::uint32_t>(cls);
+                order.push_back(t);
+            }
+        }
+    for (std::uint32_t q = 1; q < n; ++q)
+        if (!seen[q])
+            order.push_back(q);
+
+    // explicit (class, target) entries, state q owns [entryBegin[q], entryEnd[q])
+    std::vector<std::pair<std::uint32_t, StateId>> entries {};
+    std::vector<std::uint32_t> entryBegin(n, 0);
+    std::vector<std::uint32_t> entryEnd(n, 0);
+    std::vector<StateId> candidate(n, DEAD); // failure-link guess, DEAD = none
+    std::vector<bool> encoded(n, false);
+    encoded[0] = true;
+    std::vector<StateId> row(width);
+    std::vector<StateId> other(width);
+    std::unordered_map<StateId, std::uint32_t> frequency {};
+    for (std::uint32_t q : order)
+    {
+        frequency.clear();
+        StateId common {DEAD};
+        std::uint32_t best {0};
+        for (std::size_t cls = 0; cls < width; ++cls)
+        {
+            row[cls] = target(q, cls);
+            const std::uint32_t f {++frequency[row[cls]]};
+            if (f > best || (f == best && row[cls] == DEAD))
+            {
+                best = f;
+                common = row[cls];
+            }
+        }
+        std::size_t cost {width - best};
+        StateId fallback {DEAD};
+        if (q != m_start && seen[q] && parent[q] != 0)
+        {
+            const StateId p {parent[q]};
+            candidate[q] = p == m_start || candidate[p] == DEAD ? m_start : target(candidate[p], via[q]);
+            for (StateId f : {candidate[q], m_start})
+            {
+                if (f == q || !encoded[f])
+                    continue;
+                for (std::size_t cls = 0; cls < width; ++cls)
+                    other[cls] = target(f, cls);
+                std::size_t differ {0};
+                for (std::size_t cls = 0; cls < width && differ < cost; ++cls)
+                    differ += row[cls] != other[cls];
+                if (differ < cost)
+                {
+                    cost = differ;
+                    fallback = f;
+                }
+            }
+        }
+        if (fallback != DEAD)
+            for (std::size_t cls = 0; cls < width; ++cls)
+                other[cls] = target(fallback, cls);
+        m_default[q] = fallback != DEAD ? FALLBACK_ROW | fallback : common;
+        entryBegin[q] = static_cast<std::uint32_t>(entries.size());
+        for (std::size_t cls = 0; cls < width; ++cls)
+            if (fallback != DEAD ? row[cls] != other[cls] : row[cls] != common)
+                entries.push_back({static_cast<std::uint32_t>(cls), row[cls]});
+        entryEnd[q] = static_cast<std::uint32_t>(entries.size());
+        encoded[q] = true;
+    }
+
+    // first fit, densest rows first: a row's first entry is tried on each of the
+    // next PROBES free slots, then the row goes past the end. Free slots are
+    // found through nextFree, a union-find "first free slot >= i" with path halving.
+    constexpr int PROBES {32};
+    std::vector<std::uint32_t> byDensity {};
+    for (std::uint32_t q = 1; q < n; ++q)
+        if (entryEnd[q] > entryBegin[q])
+            byDensity.push_back(q);
+    std::stable_sort(byDensity.begin(), byDensity.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return entryEnd[a] - entryBegin[a] > entryEnd[b] - entryBegin[b];
+    });
+    std::vector<std::uint32_t> nextFree {}; // i if slot i is free; slots past the end are free
+    auto freeFrom = [&](std::size_t i) -> std::size_t {
+        while (i < nextFree.size() && nextFree[i] != i)
+        {
+            const std::uint32_t up {nextFree[i]};
+            if (up < nextFree.size())
+                nextFree[i] = nextFree[up];
+            i = up;
+        }
+        return i;
+    };
+    for (std::uint32_t q : byDensity)
+    {
+        const auto* first {entries.data() + entryBegin[q]};
+        const auto* last {entries.data() + entryEnd[q]};
+        const std::uint32_t lead {first->first};
+        // past the end everything fits
+        std::size_t base {std::max(nextFree.size(), std::size_t{lead}) - lead};
+        std::size_t slot {freeFrom(lead)};
+        for (int probe = 0; probe < PROBES && slot < nextFree.size(); ++probe, slot = freeFrom(slot + 1))
+        {
+            bool fits {true};
+            for (const auto* e = first + 1; e != last && fits; ++e)
+                fits = freeFrom(slot - lead + e->first) == slot - lead + e->first;
+            if (fits)
+            {
+                base = slot - lead;
+                break;
+            }
+        }
+        if (nextFree.size() < base + width)
+        {
+            std::size_t i {nextFree.size()};
+            nextFree.resize(base + width);
+            for (; i < nextFree.size(); ++i)
+                nextFree[i] = static_cast<std::uint32_t>(i);
+            m_slots.resize(base + width);
+        }
+        for (const auto* e = first; e != last; ++e)
+        {
+            nextFree[base + e->first] = static_cast<std::uint32_t>(base + e->first + 1);
+            m_slots[base + e->first] = {q, e->second};
+        }
+        m_base[q] = static_cast<std::uint32_t>(base);
+    }
+    // rows without entries sit at base 0, which must span a whole row
+    if (m_slots.size() < width)
+        m_slots.resize(width);
+}
+
+std::size_t PackedDFA::fallbackRows() const
+{
+    return static_cast<std::size_t>(std::count_if(m_default.begin(), m_default.end(),
+                                                  [](StateId d) { return (d & FALLBACK_ROW) != 0; }));
+}
+
+std::size_t PackedDFA::tableBytes() const
+{
+    return m_slots.size() * sizeof(Slot) + m_base.size() * sizeof(std::uint32_t)
+         + m_default.size() * sizeof(StateId) + m_finalBits.size() * sizeof(std::uint64_t) + sizeof(m_classOf);
+}
+
+PackedDFA::StateId PackedDFA::advance(StateId s, std::string_view chunk) const
+{
+    for (std::size_t i = 0; i < chunk.size() && s != DEAD; ++i)
+        s = next(s, static_cast<unsigned char>(chunk[i]));
+    return s;
+}
+
+bool PackedDFA::matches(std::string_view input) const
+{
+    return isFinal(advance(m_start, input));
+}
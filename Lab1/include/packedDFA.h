@@ -0,0 +1,81 @@
+#ifndef PACKED_DFA_H
+#define PACKED_DFA_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+class CompiledDFA;
+
+// Row-displacement ("comb vector") form of a CompiledDFA for automata whose
+// dense table is too big. Each state keeps only the entries that differ from
+// its fallback, which is either a single default target (the most common one
+// in its row) or the row of another state, looked up in turn. The candidate
+// fallback row is the one the Aho-Corasick failure link would name, found by
+// following the parent's fallback along the breadth-first tree edge, with the
+// start state's row as the second candidate; states fall back only to states
+// encoded before them, so chains end. The remaining entries of all rows are
+// overlaid in one slot array at per-state offsets, and every slot records its
+// owner so lookups can tell whose it is:
+//
+//   slot = base[s] + class;  owner[slot] == s ? target[slot] : fallback
+//
+// Byte classes are shared with the CompiledDFA; state 0 is dead.
+class PackedDFA
+{
+public:
+    using StateId = std::uint32_t;  // state index, not a row offset
+    static constexpr StateId DEAD {0};
+
+    explicit PackedDFA(const CompiledDFA& dfa);
+
+    bool matches(std::string_view input) const;
+    // runs `chunk` from state s, stopping early once DEAD is reached
+    StateId advance(StateId s, std::string_view chunk) const;
+    StateId next(StateId s, unsigned char c) const
+    {
+        const std::uint32_t cls {m_classOf[c]};
+        for (;;)
+        {
+            const Slot& slot {m_slots[m_base[s] + cls]};
+            if (slot.owner == s)
+                return slot.target;
+            if (!(m_default[s] & FALLBACK_ROW))
+                return m_default[s];
+            s = m_default[s] & ~FALLBACK_ROW;
+        }
+    }
+
+    //getters
+    StateId startState() const { return m_start; }
+    bool isFinal(StateId s) const { return (m_finalBits[s / 64] >> (s % 64)) & 1U; }
+    std::size_t stateCount() const { return m_base.size(); }
+    std::size_t classCount() const { return m_classCount; }
+    std::size_t slotCount() const { return m_slots.size(); }
+    // states that fall back to another state's row
+    std::size_t fallbackRows() const;
+    std::size_t tableBytes() const;
+    double bytesPerState() const { return static_cast<double>(tableBytes()) / stateCount(); }
+
+private:
+    static constexpr StateId FALLBACK_ROW {StateId{1} << 31};  // m_default flag: the rest is a state
+    static constexpr StateId NO_OWNER {~StateId{0}};
+
+    struct Slot
+    {
+        StateId owner {NO_OWNER};
+        StateId target {DEAD};
+    };
+
+    std::vector<Slot> m_slots {};
+    std::vector<std::uint32_t> m_base {};    // per state
+    std::vector<StateId> m_default {};       // per state: a target, or FALLBACK_ROW | state
+    std::vector<std::uint64_t> m_finalBits {};
+    std::array<std::uint8_t, 256> m_classOf {};
+    std::size_t m_classCount {1};
+    StateId m_start {DEAD};
+};
+
+#endif
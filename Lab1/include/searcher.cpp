@@ -0,0 +1,165 @@
+#include "searcher.h"
+#include "mappedFile.h"
+#include <algorithm>
+
+Searcher::Searcher(const FiniteAutomaton& fa, std::size_t stateBudget)
+    : m_dfa {fa.toDFA(true, stateBudget)}
+    , m_forward {m_dfa.compiledDFA()}
+    , m_reverse {(m_forward->stateCount() + 63) / 64}
+{
+    using StateId = CompiledDFA::StateId;
+    const std::size_t m {m_forward->stateCount()};
+    const std::size_t words {(m + 63) / 64};
+
+    // the forward DFA's byte classes are the reverse columns too; a byte that
+    // never leads to a live state has a class whose reverse step can only
+    // ever produce the set of final states
+    m_columns = m_forward->classCount();
+    std::array<unsigned char, 256> representative {};
+    for (unsigned c = 256; c-- > 0;)
+    {
+        m_column[c] = m_forward->classOf(static_cast<unsigned char>(c));
+        representative[m_column[c]] = static_cast<unsigned char>(c);
+    }
+
+    // reversed edges as CSR: predecessors of forward state t on column col
+    std::vector<std::uint32_t> offsets(m_columns * m + 1, 0);
+    for (StateId q = 1; q < m; ++q)
+        for (std::uint32_t col = 0; col < m_columns; ++col)
+        {
+            StateId t {m_forward->next(m_forward->rowOf(q), representative[col])};
+            if (t != CompiledDFA::DEAD)
+                ++offsets[col * m + m_forward->indexOf(t) + 1];
+        }
+    for (std::size_t i = 1; i < offsets.size(); ++i)
+        offsets[i] += offsets[i - 1];
+    std::vector<std::uint32_t> predecessors(offsets.back());
+    {
+        std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (StateId q = 1; q < m; ++q)
+            for (std::uint32_t col = 0; col < m_columns; ++col)
+            {
+                StateId t {m_forward->next(m_forward->rowOf(q), representative[col])};
+                if (t != CompiledDFA::DEAD)
+                    predecessors[fill[col * m + m_forward->indexOf(t)]++] = q;
+            }
+    }
+
+    // reverse subset construction; state 0 is "past the end": the final states
+    std::vector<std::uint64_t> finals(words, 0);
+    for (StateId q = 1; q < m; ++q)
+        if (m_forward->isFinal(m_forward->rowOf(q)))
+            finals[q / 64] |= std::uint64_t{1} << (q % 64);
+    m_reverse.insert(finals.data());
+
+    std::vector<std::uint64_t> next(words);
+    for (std::size_t b = 0; b < m_reverse.size(); ++b)
+    {
+        for (std::uint32_t col = 0; col < m_columns; ++col)
+        {
+            next = finals;
+            const SubsetView set {m_reverse.view(b)};
+            for (std::size_t w = set.lo; w < set.hi; ++w)
+                for (std::uint64_t bits = set.bits[w - set.lo]; bits; bits &= bits - 1)
+                {
+                    const std::size_t t {w * 64 + __builtin_ctzll(bits)};
+                    for (std::uint32_t i = offsets[col * m + t]; i < offsets[col * m + t + 1]; ++i)
+                        next[predecessors[i] / 64] |= std::uint64_t{1} << (predecessors[i] % 64);
+                }
+            std::size_t id {m_reverse.find(next.data())};
+            if (id == SubsetTable::NPOS)
+            {
+                if (m_reverse.size() == stateBudget)
+                    throw StateBudgetExceeded(stateBudget);
+                id = m_reverse.insert(next.data());
+            }
+            m_reverseNext.push_back(static_cast<std::uint32_t>(id));
+        }
+    }
+}
+
+bool Searcher::contains(std::uint32_t reverseState, CompiledDFA::StateId forwardRow) const
+{
+    const std::size_t q {m_forward->indexOf(forwardRow)};
+    const SubsetView set {m_reverse.view(reverseState)};
+    const std::size_t w {q / 64};
+    return w >= set.lo && w < set.hi && ((set.bits[w - set.lo] >> (q % 64)) & 1U);
+}
+
+std::vector<Span> Searcher::findAll(std::string_view text) const
+{
+    const std::size_t n {text.size()};
+    std::vector<Span> spans {};
+    const CompiledDFA::StateId start {m_forward->startState()};
+    if (start == CompiledDFA::DEAD || n == 0)
+        return spans;
+
+    // backward pass: the reverse state after reading text[x..n) right to left is
+    // needed at every x, but only kept at multiples of WINDOW; the forward pass
+    // asks for increasing x, so each window is refilled from its right-hand
+    // checkpoint once, and memory stays O(WINDOW + n / WINDOW)
+    const auto* bytes {reinterpret_cast<const unsigned char*>(text.data())};
+    auto step = [&](std::uint32_t r, std::size_t x) {
+        return m_reverseNext[static_cast<std::size_t>(r) * m_columns + m_column[bytes[x]]];
+    };
+    std::vector<std::uint32_t> checkpoints(n / WINDOW + 1);
+    {
+        std::uint32_t r {0};
+        for (std::size_t x = n; x-- > 0;)
+        {
+            r = step(r, x);
+            if (x % WINDOW == 0)
+                checkpoints[x / WINDOW] = r;
+        }
+    }
+    std::vector<std::uint32_t> window(WINDOW + 1);
+    std::size_t lo {0}, hi {0};   // window[x - lo] for x in [lo, hi]; empty until first use
+    bool filled {false};
+    auto at = [&](std::size_t x) {
+        if (!filled || x > hi)
+        {
+            lo = x / WINDOW * WINDOW;
+            hi = std::min(lo + WINDOW, n);
+            window[hi - lo] = hi == n ? 0 : checkpoints[hi / WINDOW];
+            for (std::size_t y = hi; y-- > lo;)
+                window[y - lo] = step(window[y + 1 - lo], y);
+            filled = true;
+        }
+        return window[x - lo];
+    };
+
+    // forward pass: a state is only followed while an accepting end still lies ahead,
+    // so each match stops exactly at its longest end and nothing is scanned twice
+    std::size_t p {0};
+    while (p < n)
+    {
+        CompiledDFA::StateId q {m_forward->next(start, static_cast<unsigned char>(text[p]))};
+        if (q == CompiledDFA::DEAD || !contains(at(p + 1), q))
+        {
+            ++p;
+            continue;
+        }
+        const std::size_t begin {p};
+        std::size_t k {p + 1};
+        std::size_t end {m_forward->isFinal(q) ? k : begin};
+        while (k < n)
+        {
+            CompiledDFA::StateId r {m_forward->next(q, static_cast<unsigned char>(text[k]))};
+            if (r == CompiledDFA::DEAD || !contains(at(k + 1), r))
+                break;
+            q = r;
+            ++k;
+            if (m_forward->isFinal(q))
+                end = k;
+        }
+        spans.push_back({begin, end});
+        p = end;
+    }
+    return spans;
+}
+
+std::vector<Span> Searcher::findAllInFile(const std::string& path) const
+{
+    MappedFile file {path};
+    return findAll(file.view());
+}
@@ -0,0 +1,63 @@
+#ifndef SEARCHER_H
+#define SEARCHER_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "finiteAutomaton.h"
+#include "compiledDFA.h"
+#include "denseNFA.h"
+
+// [begin, end) byte offsets of one match
+struct Span
+{
+    std::size_t begin {0};
+    std::size_t end {0};
+
+    bool operator==(const Span& other) const { return begin == other.begin && end == other.end; }
+};
+
+// Unanchored search for every occurrence of the language, grep style:
+// non-overlapping, non-empty, leftmost-longest spans.
+//
+// One backward pass runs a DFA built from the reversed automaton; at each
+// position p it records the set of forward DFA states from which some
+// prefix of text[p..] is accepted. Match starts are the positions where the
+// forward start state can take a step and stay in that set, and the forward
+// DFA then extends each match exactly as far as its longest end. This is the
+// forward-ends, reverse-starts scheme turned around: with the reverse pass
+// first, the forward pass settles every leftmost match's longest end without
+// restarting. The per-position record is kept only for one WINDOW of bytes at
+// a time, recomputed from checkpoints every WINDOW bytes, so every byte is
+// read at most three times and scratch memory stays O(WINDOW + n / WINDOW)
+// (256 KiB of checkpoints for a 4 GiB mapped file).
+class Searcher
+{
+public:
+    explicit Searcher(const FiniteAutomaton& fa, std::size_t stateBudget = FiniteAutomaton::DEFAULT_STATE_BUDGET);
+
+    std::vector<Span> findAll(std::string_view text) const;
+    // memory-maps the file (see MappedFile) and searches it in place
+    std::vector<Span> findAllInFile(const std::string& path) const;
+
+    //getters
+    std::size_t forwardStates() const { return m_forward->stateCount(); }
+    std::size_t reverseStates() const { return m_reverse.size(); }
+
+private:
+    static constexpr std::size_t WINDOW {std::size_t{1} << 16};  // bytes of reverse states kept at once
+
+    bool contains(std::uint32_t reverseState, CompiledDFA::StateId forwardRow) const;
+
+    FiniteAutomaton m_dfa {};                   // minimized forward DFA, owns m_forward
+    const CompiledDFA* m_forward {nullptr};
+    SubsetTable m_reverse;                      // reverse DFA state -> set of forward states
+    std::array<std::uint32_t, 256> m_column {}; // byte -> reverse column
+    std::size_t m_columns {0};
+    std::vector<std::uint32_t> m_reverseNext {}; // reverse state * columns + column
+};
+
+#endif
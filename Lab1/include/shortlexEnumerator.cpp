@@ -0,0 +1,115 @@
+#include "shortlexEnumerator.h"
+#include "finiteAutomaton.h"
+#include <algorithm>
+
+ShortlexEnumerator::ShortlexEnumerator(const FiniteAutomaton& fa, std::size_t maxLength)
+{
+    const FiniteAutomaton dfa {fa.toDFA(true)};
+    const std::size_t n {dfa.stateCount()};
+    m_start = static_cast<std::uint32_t>(dfa.initialIndex());
+    m_rowWords = std::max<std::size_t>((n + 63) / 64, 1);
+
+    // names sorted once, so every row can be ordered by rank
+    std::vector<std::uint32_t> used {};
+    for (std::size_t s = 0; s < n; ++s)
+        for (auto t = dfa.transitionsBegin(s); t != dfa.transitionsEnd(s); ++t)
+            used.push_back(t->symbol);
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+    std::sort(used.begin(), used.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return dfa.symbols().name(a) < dfa.symbols().name(b);
+    });
+    std::vector<std::uint32_t> rank(dfa.symbols().size(), 0);
+    std::vector<std::uint32_t> nameBegin(dfa.symbols().size(), 0);
+    for (std::uint32_t i = 0; i < used.size(); ++i)
+    {
+        rank[used[i]] = i;
+        nameBegin[used[i]] = static_cast<std::uint32_t>(m_names.size());
+        m_names += dfa.symbols().name(used[i]);
+    }
+
+    std::vector<std::pair<std::uint32_t, Edge>> row {};
+    for (std::size_t s = 0; s < n; ++s)
+    {
+        row.clear();
+        for (auto t = dfa.transitionsBegin(s); t != dfa.transitionsEnd(s); ++t)
+            row.push_back({rank[t->symbol], {t->to, nameBegin[t->symbol],
+                                             static_cast<std::uint32_t>(dfa.symbols().name(t->symbol).size())}});
+        std::sort(row.begin(), row.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& [r, e] : row)
+            m_edges.push_back(e);
+        m_offsets.push_back(static_cast<std::uint32_t>(m_edges.size()));
+    }
+
+    // reach(0) = finals, reach(r) = states with an edge into reach(r - 1)
+    m_reach.assign((maxLength + 1) * m_rowWords, 0);
+    for (std::uint32_t q = 0; q < n; ++q)
+        if (dfa.isFinal(q))
+            m_reach[q / 64] |= std::uint64_t{1} << (q % 64);
+    for (std::size_t r = 1; r <= maxLength; ++r)
+        for (std::uint32_t q = 0; q < n; ++q)
+            for (std::uint32_t e = m_offsets[q]; e < m_offsets[q + 1]; ++e)
+                if (reaches(r - 1, m_edges[e].to))
+                {
+                    m_reach[r * m_rowWords + q / 64] |= std::uint64_t{1} << (q % 64);
+                    break;
+                }
+}
+
+void ShortlexEnumerator::reset()
+{
+    m_stack.clear();
+    m_word.clear();
+    m_length = 0;
+    m_started = false;
+}
+
+bool ShortlexEnumerator::next(std::string& word)
+{
+    if (!m_started)
+    {
+        m_started = true;
+        if (reaches(0, m_start))
+        {
+            word.clear();
+            return true;
+        }
+    }
+    while (true)
+    {
+        if (m_stack.empty())
+        {
+            // the previous length is used up; find the next one the start state reaches
+            do
+                ++m_length;
+            while (m_length <= maxLength() && !reaches(m_length, m_start));
+            if (m_length > maxLength())
+            {
+                m_length = maxLength();
+                return false;
+            }
+            m_stack.push_back({m_start, m_offsets[m_start], 0});
+        }
+
+        Frame& top {m_stack.back()};
+        m_word.resize(top.wordSize);
+        const std::size_t remaining {m_length - m_stack.size()};
+        std::uint32_t e {top.cursor};
+        while (e < m_offsets[top.state + 1] && !reaches(remaining, m_edges[e].to))
+            ++e;
+        if (e == m_offsets[top.state + 1])
+        {
+            m_stack.pop_back();
+            continue;
+        }
+        top.cursor = e + 1;
+        const Edge& edge {m_edges[e]};
+        m_word.append(m_names, edge.nameBegin, edge.nameLength);
+        if (remaining == 0)
+        {
+            word = m_word;
+            return true;
+        }
+        m_stack.push_back({edge.to, m_offsets[edge.to], m_word.size()});
+    }
+}
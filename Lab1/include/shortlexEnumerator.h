@@ -0,0 +1,69 @@
+#ifndef SHORTLEX_ENUMERATOR_H
+#define SHORTLEX_ENUMERATOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class FiniteAutomaton;
+
+// Every accepted word of at most maxLength symbols, shortest first and in
+// lexicographic order of symbol names within a length, one at a time. Runs
+// over the minimal DFA (determinized first if needed, so no word comes out
+// twice) as a depth-first walk of one frame per symbol, with each state's
+// edges sorted by name. A bit table of which states reach a final state in
+// exactly r symbols, r = 0 .. maxLength, lets the walk enter only edges that
+// still lead to a word of the current length, so there are no dead ends: the
+// next word is at most maxLength pushes and pops away, whatever the size of
+// the language. Lengths from which the start state reaches no final state
+// are skipped. The table holds (maxLength + 1) * states bits.
+class ShortlexEnumerator
+{
+public:
+    ShortlexEnumerator(const FiniteAutomaton& fa, std::size_t maxLength);
+
+    // sets `word` to the next word; false once every word has come out
+    bool next(std::string& word);
+    // starts over from the shortest word
+    void reset();
+
+    //getters
+    std::size_t maxLength() const { return m_reach.size() / m_rowWords - 1; }
+    // symbols in the word `next` produced last
+    std::size_t currentLength() const { return m_length; }
+
+private:
+    struct Edge
+    {
+        std::uint32_t to;
+        std::uint32_t nameBegin;   // into m_names
+        std::uint32_t nameLength;
+    };
+
+    struct Frame
+    {
+        std::uint32_t state;
+        std::uint32_t cursor;      // next edge of state to try
+        std::size_t wordSize;      // m_word's size when the frame was entered
+    };
+
+    bool reaches(std::size_t r, std::uint32_t q) const
+    {
+        return (m_reach[r * m_rowWords + q / 64] >> (q % 64)) & 1;
+    }
+
+    std::vector<std::uint32_t> m_offsets {0};     // CSR rows of m_edges, one per state, by name
+    std::vector<Edge> m_edges {};
+    std::string m_names {};
+    std::vector<std::uint64_t> m_reach {};        // row r: states reaching a final state in exactly r symbols
+    std::size_t m_rowWords {1};
+    std::uint32_t m_start {0};
+
+    std::vector<Frame> m_stack {};
+    std::string m_word {};
+    std::size_t m_length {0};                     // symbols in the words being walked
+    bool m_started {false};
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef STATIC_DFA_H
+#define STATIC_DFA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+// One NFA edge for StaticDFA; states are named by single characters and
+// symbol '\0' stands for epsilon.
+struct StaticEdge
+{
+    char from;
+    char symbol;
+    char to;
+};
+
+// A DFA built entirely at compile time from a literal transition list or a
+// right-linear grammar: epsilon closures and the subset construction run in
+// constexpr functions, so a `static constexpr` StaticDFA is just a few arrays
+// in read-only data and costs nothing at startup.
+//
+// Every terminal character gets its own column and all other bytes share
+// column 0, which only leads to the dead state 0. The NFA may have at most 64
+// states (a subset is a uint64_t); exceeding MaxStates DFA states or
+// MaxClasses - 1 terminals is a compile error when evaluated as a constant.
+template <std::size_t MaxStates = 64, std::size_t MaxClasses = 16>
+class StaticDFA
+{
+    static_assert(MaxStates >= 2 && MaxStates <= 256, "state ids are stored in one byte");
+    static_assert(MaxClasses >= 2 && MaxClasses <= 256, "class ids are stored in one byte");
+
+public:
+    using StateId = std::uint8_t;
+    static constexpr StateId DEAD {0};
+
+    // `finals` lists the accepting state names
+    template <std::size_t N>
+    static constexpr StaticDFA fromTransitions(const StaticEdge (&edges)[N], char start, std::string_view finals)
+    {
+        return build(edges, N, start, finals);
+    }
+
+    // productions in Lab1 notation: "S->aP", "P->e", "S->" (epsilon); like
+    // Grammar::toFiniteAutomaton, terminal-only and empty right-hand sides
+    // lead to an extra accepting state
+    template <std::size_t N>
+    static constexpr StaticDFA fromGrammar(const char* const (&productions)[N], char start)
+    {
+        constexpr char ACCEPT {'\0'};
+        std::array<StaticEdge, N> edges {};
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            const std::string_view p {productions[i]};
+            const std::size_t arrow {p.find("->")};
+            if (arrow != 1)
+                throw std::invalid_argument("StaticDFA: a production is \"A->aB\", \"A->a\" or \"A->\"");
+            const std::string_view rhs {p.substr(3)};
+            if (rhs.size() > 2)
+                throw std::invalid_argument("StaticDFA: grammar is not right-linear");
+            edges[i] = {p[0], rhs.empty() ? '\0' : rhs[0], rhs.size() == 2 ? rhs[1] : ACCEPT};
+        }
+        return build(edges.data(), N, start, std::string_view(&ACCEPT, 1));
+    }
+
+    constexpr bool matches(std::string_view input) const
+    {
+        StateId s {m_start};
+        for (char c : input)
+            s = m_next[s][m_classOf[static_cast<unsigned char>(c)]];
+        return m_final[s];
+    }
+
+    //getters
+    constexpr std::size_t stateCount() const { return m_stateCount; }
+    constexpr std::size_t classCount() const { return m_classCount; }
+
+private:
+    static constexpr StaticDFA build(const StaticEdge* edges, std::size_t count, char start, std::string_view finals)
+    {
+        StaticDFA dfa {};
+
+        // NFA state ids in order of first appearance
+        std::array<char, 64> names {};
+        std::size_t n {0};
+        auto idOf = [&](char name) {
+            for (std::size_t i = 0; i < n; ++i)
+                if (names[i] == name)
+                    return i;
+            if (n == names.size())
+                throw std::invalid_argument("StaticDFA: more than 64 NFA states");
+            names[n] = name;
+            return n++;
+        };
+
+        // one column per terminal, 0 for every other byte
+        for (std::size_t e = 0; e < count; ++e)
+        {
+            const auto c {static_cast<unsigned char>(edges[e].symbol)};
+            if (c != 0 && dfa.m_classOf[c] == 0)
+            {
+                if (dfa.m_classCount == MaxClasses)
+                    throw std::invalid_argument("StaticDFA: more terminals than MaxClasses - 1");
+                dfa.m_classOf[c] = static_cast<std::uint8_t>(dfa.m_classCount++);
+            }
+        }
+
+        std::array<std::uint64_t, 64> epsilon {};
+        std::array<std::array<std::uint64_t, MaxClasses>, 64> move {};
+        const std::size_t initial {idOf(start)};
+        for (std::size_t e = 0; e < count; ++e)
+        {
+            const std::size_t from {idOf(edges[e].from)};
+            const std::uint64_t to {std::uint64_t{1} << idOf(edges[e].to)};
+            if (edges[e].symbol == '\0')
+                epsilon[from] |= to;
+            else
+                move[from][dfa.m_classOf[static_cast<unsigned char>(edges[e].symbol)]] |= to;
+        }
+        std::uint64_t accepting {0};
+        for (char f : finals)
+            for (std::size_t i = 0; i < n; ++i)
+                if (names[i] == f)
+                    accepting |= std::uint64_t{1} << i;
+
+        auto closure = [&](std::uint64_t set) {
+            for (std::uint64_t previous = 0; previous != set;)
+            {
+                previous = set;
+                for (std::size_t q = 0; q < n; ++q)
+                    if ((set >> q) & 1U)
+                        set |= epsilon[q];
+            }
+            return set;
+        };
+
+        // subset construction; subset 0 is the empty set, i.e. the dead state
+        std::array<std::uint64_t, MaxStates> subsets {};
+        auto find = [&](std::uint64_t set) {
+            for (std::size_t i = 0; i < dfa.m_stateCount; ++i)
+                if (subsets[i] == set)
+                    return i;
+            if (dfa.m_stateCount == MaxStates)
+                throw std::invalid_argument("StaticDFA: more DFA states than MaxStates");
+            subsets[dfa.m_stateCount] = set;
+            dfa.m_final[dfa.m_stateCount] = (set & accepting) != 0;
+            return dfa.m_stateCount++;
+        };
+        dfa.m_start = static_cast<StateId>(find(closure(std::uint64_t{1} << initial)));
+        for (std::size_t i = 1; i < dfa.m_stateCount; ++i)
+            for (std::size_t c = 1; c < dfa.m_classCount; ++c)
+            {
+                std::uint64_t next {0};
+                for (std::size_t q = 0; q < n; ++q)
+                    if ((subsets[i] >> q) & 1U)
+                        next |= move[q][c];
+                dfa.m_next[i][c] = static_cast<StateId>(find(closure(next)));
+            }
+        return dfa;
+    }
+
+    std::array<std::uint8_t, 256> m_classOf {};
+    std::array<std::array<StateId, MaxClasses>, MaxStates> m_next {};
+    std::array<bool, MaxStates> m_final {};
+    std::size_t m_stateCount {1};
+    std::size_t m_classCount {1};
+    StateId m_start {DEAD};
+};
+
+#endif
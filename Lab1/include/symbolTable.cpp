@@ -0,0 +1,67 @@
+#include "symbolTable.h"
+#include <functional>
+
+namespace
+{
+    std::uint64_t hashOf(std::string_view name)
+    {
+        return std::hash<std::string_view>{}(name);
+    }
+
+    constexpr std::uint64_t TAG_MASK {0xFFFFFFFF00000000ULL};
+}
+
+SymbolTable::SymbolTable()
+    : m_slots(64, 0)
+{
+    intern("");
+}
+
+std::size_t SymbolTable::slotOf(std::string_view name, std::uint64_t hash) const
+{
+    const std::size_t mask {m_slots.size() - 1};
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        const std::uint64_t slot {m_slots[i]};
+        if (slot == 0)
+            return i;
+        if ((slot & TAG_MASK) == (hash & TAG_MASK) && m_names[(slot & ~TAG_MASK) - 1] == name)
+            return i;
+    }
+}
+
+void SymbolTable::grow()
+{
+    std::vector<std::uint64_t> old(m_slots.size() * 2, 0);
+    old.swap(m_slots);
+    const std::size_t mask {m_slots.size() - 1};
+    for (std::uint64_t slot : old)
+    {
+        if (slot == 0)
+            continue;
+        std::size_t i {hashOf(m_names[(slot & ~TAG_MASK) - 1]) & mask};
+        while (m_slots[i])
+            i = (i + 1) & mask;
+        m_slots[i] = slot;
+    }
+}
+
+SymbolTable::Id SymbolTable::intern(std::string_view name)
+{
+    const std::uint64_t hash {hashOf(name)};
+    std::size_t i {slotOf(name, hash)};
+    if (m_slots[i])
+        return static_cast<Id>((m_slots[i] & ~TAG_MASK) - 1);
+    const Id id {static_cast<Id>(m_names.size())};
+    m_names.emplace_back(name);
+    m_slots[i] = (hash & TAG_MASK) | (std::uint64_t{id} + 1);
+    if (m_names.size() * 2 > m_slots.size())
+        grow();
+    return id;
+}
+
+SymbolTable::Id SymbolTable::find(std::string_view name) const
+{
+    const std::size_t i {slotOf(name, hashOf(name))};
+    return m_slots[i] ? static_cast<Id>((m_slots[i] & ~TAG_MASK) - 1) : NPOS;
+}
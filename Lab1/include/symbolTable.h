@@ -0,0 +1,42 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Interns state, terminal and nonterminal names to dense ids. Id 0 is always
+// the empty name, which the automata use for epsilon. Names are kept only for
+// printing and for the string-based constructors; everything else works on ids.
+// A table is filled while an automaton or grammar is built and is shared
+// read-only afterwards, so conversions copy it before adding new names.
+class SymbolTable
+{
+public:
+    using Id = std::uint32_t;
+    static constexpr Id EPSILON {0};
+    static constexpr Id NPOS {static_cast<Id>(-1)};
+
+    SymbolTable();
+    SymbolTable(const SymbolTable& other) = default;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    Id intern(std::string_view name);
+    Id find(std::string_view name) const;
+    const std::string& name(Id id) const { return m_names[id]; }
+    std::size_t size() const { return m_names.size(); }
+
+private:
+    // open addressing with linear probing; a slot holds the upper hash bits
+    // above (id + 1) so most mismatches are rejected without touching a name
+    std::size_t slotOf(std::string_view name, std::uint64_t hash) const;
+    void grow();
+
+    std::deque<std::string> m_names {};
+    std::vector<std::uint64_t> m_slots {};   // 0 = empty
+};
+
+#endif
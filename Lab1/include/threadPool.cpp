@@ -0,0 +1,78 @@
+#include "threadPool.h"
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool {};
+    return pool;
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::runTasks(const std::function<void(std::size_t)>& fn)
+{
+    for (std::size_t i = m_nextTask.fetch_add(1); i < m_tasks; i = m_nextTask.fetch_add(1))
+        fn(i);
+}
+
+void ThreadPool::workerLoop()
+{
+    std::size_t seen {0};
+    std::unique_lock<std::mutex> lock {m_mutex};
+    for (;;)
+    {
+        m_wake.wait(lock, [&] { return m_stop || (m_generation != seen && m_joined < m_allowed); });
+        if (m_stop)
+            return;
+        seen = m_generation;
+        ++m_joined;
+        ++m_busy;
+        const auto* job = m_job;
+        lock.unlock();
+        runTasks(*job);
+        lock.lock();
+        if (--m_busy == 0)
+            m_done.notify_all();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t tasks, unsigned threads, const std::function<void(std::size_t)>& fn)
+{
+    if (threads <= 1 || tasks <= 1)
+    {
+        for (std::size_t i = 0; i < tasks; ++i)
+            fn(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> call {m_callMutex};
+    {
+        std::lock_guard<std::mutex> lock {m_mutex};
+        while (m_workers.size() < threads - 1)
+            m_workers.emplace_back(&ThreadPool::workerLoop, this);
+        m_job = &fn;
+        m_tasks = tasks;
+        m_nextTask = 0;
+        m_allowed = threads - 1;
+        m_joined = 0;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    runTasks(fn);
+
+    // every task is claimed; wait for the workers still running one and
+    // keep late wakers from joining a job that is already over
+    std::unique_lock<std::mutex> lock {m_mutex};
+    m_allowed = 0;
+    m_done.wait(lock, [&] { return m_busy == 0; });
+    m_job = nullptr;
+}
@@ -0,0 +1,48 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Process-wide pool of worker threads that are started once and reused by
+// every parallelFor call, so batch APIs pay no per-call thread setup.
+class ThreadPool
+{
+public:
+    static ThreadPool& shared();
+
+    ThreadPool() = default;
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // runs fn(0) .. fn(tasks - 1) on up to `threads` threads, the caller included,
+    // and returns once all of them are done. Concurrent calls are serialized.
+    void parallelFor(std::size_t tasks, unsigned threads, const std::function<void(std::size_t)>& fn);
+
+private:
+    void workerLoop();
+    void runTasks(const std::function<void(std::size_t)>& fn);
+
+    std::vector<std::thread> m_workers {};
+    std::mutex m_callMutex {};
+    std::mutex m_mutex {};
+    std::condition_variable m_wake {};
+    std::condition_variable m_done {};
+
+    const std::function<void(std::size_t)>* m_job {nullptr};
+    std::atomic<std::size_t> m_nextTask {0};
+    std::size_t m_tasks {0};
+    unsigned m_allowed {0};        // workers that may join the current job
+    unsigned m_joined {0};
+    unsigned m_busy {0};
+    std::size_t m_generation {0};
+    bool m_stop {false};
+};
+
+#endif
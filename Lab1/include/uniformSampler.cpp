@@ -0,0 +1,201 @@
+#include "uniformSampler.h"
+#include "finiteAutomaton.h"
+#include "wordGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // a < b, c > 0 as for memcmp; both little-endian, lengths may differ
+    int compare(const std::uint64_t* a, std::size_t aLimbs, const std::uint64_t* b, std::size_t bLimbs)
+    {
+        for (std::size_t i = std::max(aLimbs, bLimbs); i-- > 0;)
+        {
+            const std::uint64_t x {i < aLimbs ? a[i] : 0};
+            const std::uint64_t y {i < bLimbs ? b[i] : 0};
+            if (x != y)
+                return x < y ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // a -= b, a >= b
+    void subtract(std::uint64_t* a, std::size_t aLimbs, const std::uint64_t* b, std::size_t bLimbs)
+    {
+        std::uint64_t borrow {0};
+        for (std::size_t i = 0; i < aLimbs; ++i)
+        {
+            const std::uint64_t y {i < bLimbs ? b[i] : 0};
+            const std::uint64_t d {a[i] - y - borrow};
+            borrow = (a[i] < y || (a[i] == y && borrow)) ? 1 : 0;
+            a[i] = d;
+        }
+    }
+
+    std::size_t significantLimbs(const std::uint64_t* a, std::size_t limbs)
+    {
+        while (limbs > 0 && a[limbs - 1] == 0)
+            --limbs;
+        return limbs;
+    }
+}
+
+BigCount::BigCount(std::vector<std::uint64_t> limbs)
+    : m_limbs {std::move(limbs)}
+{
+    m_limbs.resize(significantLimbs(m_limbs.data(), m_limbs.size()));
+}
+
+std::size_t BigCount::bitLength() const
+{
+    return isZero() ? 0 : 64 * m_limbs.size() - static_cast<std::size_t>(__builtin_clzll(m_limbs.back()));
+}
+
+double BigCount::toDouble() const
+{
+    double value {0};
+    for (std::size_t i = m_limbs.size(); i-- > 0;)
+        value = value * 18446744073709551616.0 + static_cast<double>(m_limbs[i]);
+    return value;
+}
+
+std::string BigCount::toString() const
+{
+    if (isZero())
+        return "0";
+    // peel off 19 decimal digits at a time
+    constexpr std::uint64_t CHUNK {10'000'000'000'000'000'000ULL};
+    std::vector<std::uint64_t> rest {m_limbs};
+    std::vector<std::uint64_t> chunks {};
+    while (!rest.empty())
+    {
+        unsigned __int128 remainder {0};
+        for (std::size_t i = rest.size(); i-- > 0;)
+        {
+            const unsigned __int128 current {(remainder << 64) | rest[i]};
+            rest[i] = static_cast<std::uint64_t>(current / CHUNK);
+            remainder = current % CHUNK;
+        }
+        rest.resize(significantLimbs(rest.data(), rest.size()));
+        chunks.push_back(static_cast<std::uint64_t>(remainder));
+    }
+    std::string digits {std::to_string(chunks.back())};
+    for (std::size_t i = chunks.size() - 1; i-- > 0;)
+    {
+        const std::string part {std::to_string(chunks[i])};
+        digits += std::string(19 - part.size(), '0') + part;
+    }
+    return digits;
+}
+
+UniformSampler::UniformSampler(const FiniteAutomaton& fa, std::size_t maxLength)
+{
+    const FiniteAutomaton dfa {fa.toDFA(true)};
+    m_states = dfa.stateCount();
+    m_start = dfa.initialIndex();
+
+    std::vector<std::uint32_t> nameOf(dfa.symbols().size(), ~std::uint32_t{0});
+    for (std::size_t s = 0; s < m_states; ++s)
+    {
+        for (auto t = dfa.transitionsBegin(s); t != dfa.transitionsEnd(s); ++t)
+        {
+            if (nameOf[t->symbol] == ~std::uint32_t{0})
+            {
+                nameOf[t->symbol] = static_cast<std::uint32_t>(m_names.size());
+                m_names += dfa.symbols().name(t->symbol);
+            }
+            m_edges.push_back({t->to, nameOf[t->symbol],
+                               static_cast<std::uint32_t>(dfa.symbols().name(t->symbol).size())});
+        }
+        m_offsets.push_back(static_cast<std::uint32_t>(m_edges.size()));
+    }
+
+    m_rowOffset.push_back(0);
+    m_rowLimbs.push_back(1);
+    for (std::size_t q = 0; q < m_states; ++q)
+        m_pool.push_back(dfa.isFinal(q) ? 1 : 0);
+
+    // a sum of at most |edges| counts needs at most one more limb than its terms
+    std::vector<std::uint64_t> row {};
+    for (std::size_t r = 1; r <= maxLength; ++r)
+    {
+        const std::size_t limbs {m_rowLimbs[r - 1]};
+        const std::size_t width {limbs + 1};
+        row.assign(m_states * width, 0);
+        for (std::size_t q = 0; q < m_states; ++q)
+        {
+            std::uint64_t* sum {row.data() + q * width};
+            for (std::uint32_t e = m_offsets[q]; e < m_offsets[q + 1]; ++e)
+            {
+                const std::uint64_t* term {countAt(r - 1, m_edges[e].to)};
+                std::uint64_t carry {0};
+                for (std::size_t i = 0; i < limbs; ++i)
+                {
+                    const unsigned __int128 s {static_cast<unsigned __int128>(sum[i]) + term[i] + carry};
+                    sum[i] = static_cast<std::uint64_t>(s);
+                    carry = static_cast<std::uint64_t>(s >> 64);
+                }
+                sum[limbs] += carry;
+            }
+        }
+        bool grew {false};
+        for (std::size_t q = 0; q < m_states && !grew; ++q)
+            grew = row[q * width + limbs] != 0;
+        const std::size_t kept {grew ? width : limbs};
+        m_rowOffset.push_back(m_pool.size());
+        m_rowLimbs.push_back(kept);
+        for (std::size_t q = 0; q < m_states; ++q)
+            m_pool.insert(m_pool.end(), row.begin() + q * width, row.begin() + q * width + kept);
+    }
+}
+
+BigCount UniformSampler::countWords(std::size_t n) const
+{
+    if (n > maxLength())
+        throw std::out_of_range("UniformSampler: length " + std::to_string(n) + " is past maxLength");
+    const std::uint64_t* count {countAt(n, m_start)};
+    return BigCount {std::vector<std::uint64_t>(count, count + m_rowLimbs[n])};
+}
+
+bool UniformSampler::sample(std::size_t n, Xoshiro256& rng, std::string& out) const
+{
+    if (n > maxLength())
+        throw std::out_of_range("UniformSampler: length " + std::to_string(n) + " is past maxLength");
+    const std::uint64_t* total {countAt(n, m_start)};
+    std::size_t limbs {significantLimbs(total, m_rowLimbs[n])};
+    if (limbs == 0)
+        return false;
+
+    // rank below total, by rejection on total's bit length: accepted with probability > 1/2
+    std::vector<std::uint64_t> rank(limbs);
+    const int topBits {64 - __builtin_clzll(total[limbs - 1])};
+    const std::uint64_t topMask {topBits == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << topBits) - 1};
+    do
+    {
+        for (auto& limb : rank)
+            limb = rng();
+        rank[limbs - 1] &= topMask;
+    } while (compare(rank.data(), limbs, total, limbs) >= 0);
+
+    // unrank: edges split count(r, q) into consecutive blocks of count(r-1, t)
+    std::uint32_t q {m_start};
+    for (std::size_t r = n; r > 0; --r)
+    {
+        const Edge* taken {nullptr};
+        for (std::uint32_t e = m_offsets[q]; e < m_offsets[q + 1] && !taken; ++e)
+        {
+            const std::uint64_t* block {countAt(r - 1, m_edges[e].to)};
+            if (compare(rank.data(), limbs, block, m_rowLimbs[r - 1]) < 0)
+                taken = &m_edges[e];
+            else
+            {
+                subtract(rank.data(), limbs, block, m_rowLimbs[r - 1]);
+                limbs = std::max<std::size_t>(significantLimbs(rank.data(), limbs), 1);
+            }
+        }
+        out.append(m_names, taken->nameBegin, taken->nameLength);
+        q = taken->to;
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef UNIFORM_SAMPLER_H
+#define UNIFORM_SAMPLER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class FiniteAutomaton;
+class Xoshiro256;
+
+// Unsigned integer of any size: 64-bit limbs, least significant first, no
+// leading zero limbs. Only what word counting needs.
+class BigCount
+{
+public:
+    BigCount() = default;
+    explicit BigCount(std::vector<std::uint64_t> limbs);
+
+    bool isZero() const { return m_limbs.empty(); }
+    std::size_t bitLength() const;
+    double toDouble() const;
+    // decimal
+    std::string toString() const;
+    bool operator==(const BigCount& other) const { return m_limbs == other.m_limbs; }
+    bool operator!=(const BigCount& other) const { return m_limbs != other.m_limbs; }
+
+    //getters
+    const std::vector<std::uint64_t>& limbs() const { return m_limbs; }
+
+private:
+    std::vector<std::uint64_t> m_limbs {};
+};
+
+// Uniform sampling of accepted words of an exact length, over the minimal DFA
+// of the automaton (determinized first if needed, so every word has exactly one
+// path). count(r, q), the number of paths of r symbols from q to a final
+// state, is tabulated for r = 0 .. maxLength by
+//
+//   count(0, q) = final(q),   count(r, q) = sum over q -a-> t of count(r-1, t)
+//
+// exactly, in rows of as many limbs as their largest entry needs. A sample
+// draws one number below count(n, start) and unranks it: at each step the
+// edge whose block of counts holds the number is taken, so a word costs n
+// steps of a few limb compares. Counts are symbol counts; a word is the
+// concatenation of its symbol names. The table holds about
+// states * maxLength^2 * log2(alphabet) / 128 limbs.
+class UniformSampler
+{
+public:
+    UniformSampler(const FiniteAutomaton& fa, std::size_t maxLength);
+
+    // number of accepted words of n symbols; throws std::out_of_range past maxLength()
+    BigCount countWords(std::size_t n) const;
+    // appends a uniformly drawn accepted word of n symbols; false when there is none
+    bool sample(std::size_t n, Xoshiro256& rng, std::string& out) const;
+
+    //getters
+    std::size_t maxLength() const { return m_rowOffset.size() - 1; }
+    std::size_t stateCount() const { return m_states; }
+    std::size_t tableBytes() const { return m_pool.size() * sizeof(std::uint64_t); }
+
+private:
+    struct Edge
+    {
+        std::uint32_t to;
+        std::uint32_t nameBegin;   // into m_names
+        std::uint32_t nameLength;
+    };
+
+    const std::uint64_t* countAt(std::size_t r, std::size_t q) const
+    {
+        return m_pool.data() + m_rowOffset[r] + q * m_rowLimbs[r];
+    }
+
+    std::size_t m_states {0};
+    std::uint32_t m_start {0};
+    std::vector<std::uint32_t> m_offsets {0};     // CSR rows of m_edges, one per state
+    std::vector<Edge> m_edges {};
+    std::string m_names {};
+    std::vector<std::uint64_t> m_pool {};         // row r: m_states counts of m_rowLimbs[r] limbs each
+    std::vector<std::size_t> m_rowOffset {};
+    std::vector<std::size_t> m_rowLimbs {};
+};
+
+#endif
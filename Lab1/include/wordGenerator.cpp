@@ -0,0 +1,157 @@
+#include "wordGenerator.h"
+#include "finiteAutomaton.h"
+#include <stdexcept>
+
+Xoshiro256::Xoshiro256(std::uint64_t seed)
+{
+    // splitmix64, so nearby seeds give unrelated streams and the state is never all zero
+    for (auto& word : m_state)
+    {
+        seed += 0x9E3779B97F4A7C15ULL;
+        std::uint64_t z {seed};
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        word = z ^ (z >> 31);
+    }
+}
+
+WordGenerator::WordGenerator(const FiniteAutomaton& fa, std::uint64_t seed, std::size_t maxSteps)
+    : m_canStop(fa.stateCount(), 0)
+    , m_start {fa.initialIndex()}
+    , m_maxSteps {maxSteps}
+    , m_rng {seed}
+{
+    const std::size_t n {fa.stateCount()};
+    constexpr std::uint32_t NONE {~std::uint32_t{0}};
+    auto indexOf = [&](const Transition* t) { return static_cast<std::size_t>(t - fa.transitionsBegin(0)); };
+
+    // distance to the nearest state that can stop, backwards over edges of positive weight
+    std::vector<std::vector<std::uint32_t>> predecessors(n);
+    for (std::size_t s = 0; s < n; ++s)
+        for (auto t = fa.transitionsBegin(s); t != fa.transitionsEnd(s); ++t)
+            if (fa.transitionWeight(indexOf(t)) > 0)
+                predecessors[t->to].push_back(static_cast<std::uint32_t>(s));
+    std::vector<std::uint32_t> distance(n, NONE);
+    std::vector<std::uint32_t> queue {};
+    for (std::uint32_t s = 0; s < n; ++s)
+        if (fa.isFinal(s) && fa.stopWeight(s) > 0)
+        {
+            m_canStop[s] = 1;
+            distance[s] = 0;
+            queue.push_back(s);
+        }
+    for (std::size_t head = 0; head < queue.size(); ++head)
+        for (std::uint32_t p : predecessors[queue[head]])
+            if (distance[p] == NONE)
+            {
+                distance[p] = distance[queue[head]] + 1;
+                queue.push_back(p);
+            }
+    if (n == 0 || distance[m_start] == NONE)
+        throw std::invalid_argument("WordGenerator: the automaton produces no word");
+
+    std::vector<std::uint32_t> nameOf(fa.symbols().size(), NONE);
+    std::vector<double> weights {};
+    m_shortest.assign(n, NONE);
+    for (std::size_t s = 0; s < n; ++s)
+    {
+        const std::size_t begin {m_edges.size()};
+        weights.clear();
+        for (auto t = fa.transitionsBegin(s); t != fa.transitionsEnd(s); ++t)
+        {
+            const double weight {fa.transitionWeight(indexOf(t))};
+            if (weight <= 0 || distance[t->to] == NONE)
+                continue;
+            if (nameOf[t->symbol] == NONE)
+            {
+                nameOf[t->symbol] = static_cast<std::uint32_t>(m_names.size());
+                m_names += fa.symbols().name(t->symbol);
+            }
+            if (distance[t->to] + 1 == distance[s] && m_shortest[s] == NONE)
+                m_shortest[s] = static_cast<std::uint32_t>(m_edges.size());
+            m_edges.push_back({t->to, nameOf[t->symbol],
+                               static_cast<std::uint32_t>(fa.symbols().name(t->symbol).size()), 0, 0});
+            weights.push_back(weight);
+        }
+        if (m_canStop[s])
+        {
+            m_edges.push_back({STOP, 0, 0, 0, 0});
+            weights.push_back(fa.stopWeight(s));
+        }
+        buildAlias(begin, m_edges.size(), weights);
+        m_offsets.push_back(static_cast<std::uint32_t>(m_edges.size()));
+    }
+}
+
+void WordGenerator::buildAlias(std::size_t begin, std::size_t end, const std::vector<double>& weights)
+{
+    const std::size_t k {end - begin};
+    double total {0};
+    for (double w : weights)
+        total += w;
+    // scaled[i] is column i's share times k: columns under 1 are topped up by one over 1
+    std::vector<double> scaled(k);
+    std::vector<std::uint32_t> small {}, large {};
+    for (std::size_t i = 0; i < k; ++i)
+    {
+        scaled[i] = weights[i] * static_cast<double>(k) / total;
+        (scaled[i] < 1 ? small : large).push_back(static_cast<std::uint32_t>(i));
+    }
+    constexpr double ONE {4294967296.0};
+    while (!small.empty() && !large.empty())
+    {
+        const std::uint32_t under {small.back()};
+        const std::uint32_t over {large.back()};
+        small.pop_back();
+        Edge& column {m_edges[begin + under]};
+        column.threshold = static_cast<std::uint64_t>(scaled[under] * ONE);
+        column.alias = static_cast<std::uint32_t>(begin + over);
+        scaled[over] -= 1 - scaled[under];
+        if (scaled[over] < 1)
+        {
+            large.pop_back();
+            small.push_back(over);
+        }
+    }
+    // what is left is full up to rounding
+    for (const auto* rest : {&small, &large})
+        for (std::uint32_t i : *rest)
+        {
+            m_edges[begin + i].threshold = std::uint64_t{1} << 32;
+            m_edges[begin + i].alias = static_cast<std::uint32_t>(begin + i);
+        }
+}
+
+void WordGenerator::next(std::string& out)
+{
+    std::uint32_t s {m_start};
+    for (std::size_t steps = 0; steps < m_maxSteps; ++steps)
+    {
+        const std::uint32_t begin {m_offsets[s]};
+        const std::uint64_t columns {m_offsets[s + 1] - begin};
+        const std::uint64_t r {m_rng()};
+        const Edge* e {&m_edges[begin + ((r >> 32) * columns >> 32)]};
+        if ((r & 0xFFFFFFFFULL) >= e->threshold)
+            e = &m_edges[e->alias];
+        if (e->to == STOP)
+            return;
+        out.append(m_names, e->nameBegin, e->nameLength);
+        s = e->to;
+    }
+    while (!m_canStop[s])
+    {
+        const Edge& e {m_edges[m_shortest[s]]};
+        out.append(m_names, e.nameBegin, e.nameLength);
+        s = e.to;
+    }
+}
+
+void WordGenerator::generate(std::size_t count, std::string& buffer, std::vector<std::size_t>& ends)
+{
+    ends.reserve(ends.size() + count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        next(buffer);
+        ends.push_back(buffer.size());
+    }
+}
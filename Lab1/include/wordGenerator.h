@@ -0,0 +1,104 @@
+#ifndef WORD_GENERATOR_H
+#define WORD_GENERATOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class FiniteAutomaton;
+
+// xoshiro256** (Blackman & Vigna), seeded through splitmix64. Small, fast and
+// reproducible across platforms, unlike the standard distributions; usable
+// wherever a UniformRandomBitGenerator is expected.
+class Xoshiro256
+{
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256(std::uint64_t seed = 0);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type{0}; }
+    result_type operator()()
+    {
+        const std::uint64_t result {rotl(m_state[1] * 5, 7) * 9};
+        const std::uint64_t t {m_state[1] << 17};
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+    // in [0, n), by multiply-shift on the top 32 bits (bias below 2^-32 * n)
+    std::uint32_t below(std::uint32_t n) { return static_cast<std::uint32_t>(((*this)() >> 32) * n >> 32); }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    std::uint64_t m_state[4] {};
+};
+
+// Random accepted words of an automaton, for bulk test input. Only edges into
+// states that can still end a word are kept, in per-state arrays with their
+// symbol names pooled. At a final state stopping is one more choice next to
+// its edges. Choices follow the automaton's weights (all 1 when unweighted,
+// see FiniteAutomaton::withWeights) through a Walker alias table per state, so
+// a step is one random number and one copy whatever the out-degree: the top
+// half picks a column, the bottom half keeps it or takes its alias. Edges and
+// stops of weight 0 are left out. After maxSteps steps the walk finishes along
+// a shortest path to a state where it can stop.
+// Throws std::invalid_argument when no word can be produced.
+class WordGenerator
+{
+public:
+    explicit WordGenerator(const FiniteAutomaton& fa, std::uint64_t seed = 0, std::size_t maxSteps = 20);
+
+    // appends one word to `out`
+    void next(std::string& out);
+    // appends `count` words back to back to `buffer` and one past the end of each to `ends`
+    void generate(std::size_t count, std::string& buffer, std::vector<std::size_t>& ends);
+    // calls sink(std::string_view) for each of `count` words; a view lasts until the call returns
+    template <class Sink>
+    void generate(std::size_t count, Sink&& sink)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            m_word.clear();
+            next(m_word);
+            sink(std::string_view {m_word});
+        }
+    }
+
+    void seed(std::uint64_t seed) { m_rng = Xoshiro256 {seed}; }
+
+private:
+    static constexpr std::uint32_t STOP {~std::uint32_t{0}};  // Edge::to of the stop column
+
+    struct Edge
+    {
+        std::uint32_t to;          // or STOP
+        std::uint32_t nameBegin;   // into m_names
+        std::uint32_t nameLength;  // 0 for epsilon
+        std::uint32_t alias;       // column taken when the coin is at or above threshold
+        std::uint64_t threshold;   // out of 2^32
+    };
+
+    // Vose's construction over the columns [begin, end) of m_edges
+    void buildAlias(std::size_t begin, std::size_t end, const std::vector<double>& weights);
+
+    std::vector<std::uint32_t> m_offsets {0};  // CSR rows of m_edges (alias columns), one per state
+    std::vector<Edge> m_edges {};
+    std::vector<std::uint32_t> m_shortest {};  // per live state that cannot stop: its edge on a shortest path to one that can
+    std::vector<std::uint8_t> m_canStop {};
+    std::string m_names {};
+    std::uint32_t m_start {0};
+    std::size_t m_maxSteps {20};
+    Xoshiro256 m_rng {};
+    std::string m_word {};                     // scratch for the sink form
+};
+
+#endif
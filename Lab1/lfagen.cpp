@@ -0,0 +1,91 @@
+// lfagen: turns an automaton description into a standalone C++ matcher.
+//
+//   lfagen <input.fa | input.grammar> <functionName> <outputBase>
+//
+// writes <outputBase>.h and <outputBase>.cpp. A .fa file uses the text form
+// read by FiniteAutomaton::loadText. A .grammar file has one right-linear
+// production per line, "LHS -> terminal [Nonterminal]", with symbols
+// separated by spaces and "ε" or nothing for an empty right-hand side; the
+// first left-hand side is the start symbol and '#' starts a comment.
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include "codeGenerator.h"
+#include "grammar.h"
+#include "mappedFile.h"
+
+namespace
+{
+    Grammar readGrammar(const std::string& path)
+    {
+        MappedFile file {path};
+        std::istringstream in {std::string(file.view())};
+        std::set<Symbol> terminals {}, nonterminals {}, rhsSymbols {};
+        std::vector<Production> productions {};
+        Symbol start {};
+        std::string line {};
+        for (int number = 1; std::getline(in, line); ++number)
+        {
+            std::istringstream tokens {line.substr(0, line.find('#'))};
+            Production p {};
+            std::string token {};
+            if (!(tokens >> token))
+                continue;
+            p.lhs.push_back(token);
+            if (!(tokens >> token) || token != "->")
+                throw std::invalid_argument(path + ":" + std::to_string(number) + ": expected \"LHS -> ...\"");
+            while (tokens >> token)
+                if (token != "ε")
+                    p.rhs.push_back(token);
+            if (start.empty())
+                start = p.lhs[0];
+            nonterminals.insert(p.lhs[0]);
+            rhsSymbols.insert(p.rhs.begin(), p.rhs.end());
+            productions.push_back(std::move(p));
+        }
+        if (start.empty())
+            throw std::invalid_argument(path + ": no productions");
+        for (const auto& s : rhsSymbols)
+            if (!nonterminals.count(s))
+                terminals.insert(s);
+        return Grammar {terminals, nonterminals, start, productions};
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << "usage: lfagen <input.fa|input.grammar> <functionName> <outputBase>\n";
+        return 2;
+    }
+    const std::filesystem::path input {argv[1]};
+    const std::string name {argv[2]};
+    const std::filesystem::path base {argv[3]};
+    try
+    {
+        FiniteAutomaton fa {input.extension() == ".grammar"
+                                ? readGrammar(input.string()).toFiniteAutomaton()
+                                : FiniteAutomaton::loadText(input.string())};
+        CodeGenerator generator {fa, name};
+
+        const std::string header {base.filename().string() + ".h"};
+        if (base.has_parent_path())
+            std::filesystem::create_directories(base.parent_path());
+        std::ofstream h {base.string() + ".h"};
+        generator.writeHeader(h);
+        std::ofstream cpp {base.string() + ".cpp"};
+        generator.writeSource(cpp, header);
+        if (!h || !cpp)
+            throw std::runtime_error("cannot write " + base.string() + ".{h,cpp}");
+        std::cout << "lfagen: " << name << ", " << generator.stateCount() << " states\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "lfagen: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,7 +1,29 @@
 #include <iostream>
 #include <set>
 #include <vector>
+#include <map>
+#include <string>
+#include <cstring>
+#include <random>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
 #include "grammar.h"
+#include "lazyDFA.h"
+#include "matcherState.h"
+#include "searcher.h"
+#include "staticDFA.h"
+#include "basicDFA.h"
+#include "packedDFA.h"
+#include "wordGenerator.h"
+#include "uniformSampler.h"
+#include "shortlexEnumerator.h"
+#include "approximateMatcher.h"
+#include "denseNFA.h"
+#include "token.h"
+#include "variantMatches.h"
+#include "identifierMatches.h"
 #include "cassert"
 
 int main()
@@ -50,6 +72,705 @@ int main()
     assert(!fa.stringBelongsToLanguage("helpmeiamtired"));
     assert(!fa.stringBelongsToLanguage("bfee"));
     assert(!fa.stringBelongsToLanguage("befx"));
+
+    // ===== GRAMMAR CACHE =====
+    {
+        // the same grammar built elsewhere, productions in another order, shares the artifacts
+        std::vector<Production> reversed(productions.rbegin(), productions.rend());
+        Grammar twin{terminals, nonterminals, start, reversed};
+        assert(twin.contentHash() == g.contentHash());
+        assert(&twin.toFiniteAutomaton() == &g.toFiniteAutomaton() && &twin.toMatcher() == &g.toMatcher());
+        assert(g.toMatcher().compiledDFA() != nullptr && g.toMatcher().equivalentTo(fa));
+        Grammar fewer{terminals, nonterminals, start, {productions.begin(), productions.end() - 1}};
+        assert(fewer.contentHash() != g.contentHash() && &fewer.toFiniteAutomaton() != &g.toFiniteAutomaton());
+
+        // first use from several threads at once: one build, one shared matcher
+        reversed.push_back({{"Q"}, {"b", "Q"}});
+        Grammar fresh{terminals, nonterminals, start, reversed};
+        std::vector<const FiniteAutomaton*> built(8, nullptr);
+        std::vector<std::thread> workers {};
+        for (std::size_t i = 0; i < built.size(); ++i)
+            workers.emplace_back([&, i] { built[i] = &fresh.toMatcher(); });
+        for (auto& w : workers)
+            w.join();
+        for (const FiniteAutomaton* m : built)
+            assert(m == built[0]);
+        assert(built[0]->stringBelongsToLanguage("bbfa") && !fa.stringBelongsToLanguage("bbfa"));
+    }
+
+    // ===== WORD GENERATION =====
+    {
+        WordGenerator first = g.wordGenerator(7), again = g.wordGenerator(7), other = g.wordGenerator(8);
+        std::string buffer {}, same {}, different {};
+        std::vector<std::size_t> ends {}, sameEnds {}, differentEnds {};
+        first.generate(1000, buffer, ends);
+        again.generate(1000, same, sameEnds);
+        other.generate(1000, different, differentEnds);
+        assert(buffer == same && ends == sameEnds && buffer != different);
+        assert(ends.size() == 1000 && ends.back() == buffer.size());
+        for (std::size_t i = 0, begin = 0; i < ends.size(); begin = ends[i++])
+            assert(fa.stringBelongsToLanguage(std::string_view(buffer).substr(begin, ends[i] - begin)));
+
+        // out of steps at once: the shortest path, taking the first symbol on ties
+        WordGenerator shortest {fa, 1, 0};
+        std::size_t count {0};
+        shortest.generate(50, [&](std::string_view w) { count += w == "ae"; });
+        assert(count == 50);
+        bool threw {false};
+        try { WordGenerator {FiniteAutomaton::fromText("%initial S\n%final F\nS a X\n")}; }
+        catch (const std::invalid_argument&) { threw = true; }
+        assert(threw);
+        Xoshiro256 rng {3};
+        assert(std::uniform_int_distribution<int>(1, 6)(rng) <= 6 && rng.below(5) < 5);
+
+        // weights: a three times as likely as b, and stopping rare
+        FiniteAutomaton ab = FiniteAutomaton::fromText("%initial S\n%final S\nS a S\nS b S\n");
+        WordGenerator weighted {ab.withWeights({3, 1}, {0.04}), 2, 1000};
+        std::size_t as {0}, letters {0};
+        weighted.generate(2000, [&](std::string_view w) {
+            as += static_cast<std::size_t>(std::count(w.begin(), w.end(), 'a'));
+            letters += w.size();
+        });
+        assert(letters > 2000 * 10 && as > letters * 70 / 100 && as < letters * 80 / 100);
+        threw = false;
+        try { ab.withWeights({1}); }
+        catch (const std::invalid_argument&) { threw = true; }
+        assert(threw);
+
+        // learned from a corpus without smoothing, only "ba" and "bffa"-like paths stay
+        FiniteAutomaton learned = fa.learnWeights({"ba", "ba", "bffa", "not a word"}, 0);
+        assert(learned.isWeighted() && learned.stopWeight(learned.initialIndex()) == 0);
+        WordGenerator replay {learned, 4};
+        replay.generate(500, [&](std::string_view w) {
+            assert(w.front() == 'b' && w.back() == 'a' && w.find_first_not_of("bfa") == std::string_view::npos);
+        });
+    }
+
+    // ===== UNIFORM SAMPLING =====
+    {
+        UniformSampler sampler {fa, 300};
+        // counts against brute force over {a..f}^n
+        std::vector<std::string> words {""};
+        std::vector<std::size_t> byLength(7, 0);
+        for (std::size_t i = 0; i < words.size(); ++i)
+        {
+            byLength[words[i].size()] += fa.stringBelongsToLanguage(words[i]);
+            if (words[i].size() < 6)
+                for (char c : std::string("abcdef"))
+                    words.push_back(words[i] + c);
+        }
+        for (std::size_t n = 0; n <= 6; ++n)
+            assert(sampler.countWords(n).toString() == std::to_string(byLength[n]));
+        assert(sampler.countWords(300).bitLength() > 64);  // past 64 bits, still exact
+        Xoshiro256 rng {11};
+        std::string word {};
+        for (std::size_t n : {2, 5, 40, 300})
+        {
+            word.clear();
+            assert(sampler.sample(n, rng, word) && word.size() == n && fa.stringBelongsToLanguage(word));
+        }
+        assert(!sampler.sample(0, rng, word));
+
+        // (a|b)*: 2^100 words of length 100, and the 8 words of length 3 come out evenly
+        UniformSampler binary {FiniteAutomaton::fromText("%initial S\n%final S\nS a S\nS b S\n"), 100};
+        assert(binary.countWords(100).toString() == "1267650600228229401496703205376");
+        std::map<std::string, int> seen {};
+        for (int i = 0; i < 8000; ++i)
+        {
+            word.clear();
+            binary.sample(3, rng, word);
+            ++seen[word];
+        }
+        assert(seen.size() == 8);
+        for (const auto& [w, hits] : seen)
+            assert(hits > 800 && hits < 1200);
+        bool threw {false};
+        try { binary.countWords(101); }
+        catch (const std::out_of_range&) { threw = true; }
+        assert(threw);
+    }
+
+    // ===== SHORTLEX ENUMERATION =====
+    {
+        // every word up to 7 symbols, once, shortest first then alphabetical, as many as countWords says
+        ShortlexEnumerator words {fa, 7};
+        UniformSampler sampler {fa, 7};
+        std::string word {}, previous {}, shortest {};
+        std::vector<std::size_t> byLength(8, 0);
+        bool first {true};
+        while (words.next(word))
+        {
+            assert(fa.stringBelongsToLanguage(word) && words.currentLength() == word.size());
+            assert(first || previous.size() < word.size() || (previous.size() == word.size() && previous < word));
+            ++byLength[word.size()];
+            if (first)
+                shortest = word;
+            previous = word;
+            first = false;
+        }
+        for (std::size_t n = 0; n <= 7; ++n)
+            assert(sampler.countWords(n).toString() == std::to_string(byLength[n]));
+        assert(!words.next(word));
+        words.reset();
+        assert(words.next(word) && word == shortest);
+
+        // (a|b)* to 60 symbols has 2^61 - 1 words; the first ones come out at once
+        ShortlexEnumerator binary {FiniteAutomaton::fromText("%initial S\n%final S\nS b S\nS a S\n"), 60};
+        std::vector<std::string> expected {"", "a", "b", "aa", "ab", "ba", "bb", "aaa"};
+        for (const auto& e : expected)
+            assert(binary.next(word) && word == e);
+
+        // a(bb)*: only odd lengths, and 100 symbols are never reached
+        ShortlexEnumerator odd {FiniteAutomaton::fromText("%initial S\n%final A\nS a A\nA b B\nB b A\n"), 100};
+        std::size_t count {0};
+        while (odd.next(word))
+        {
+            assert(word.size() % 2 == 1);
+            ++count;
+        }
+        assert(count == 50 && word == "a" + std::string(98, 'b'));
+    }
+
+    // ===== APPROXIMATE MATCHING =====
+    {
+        // against brute force: the words one or two edits from s, over {a..f}, tested one by one
+        auto ball = [](const std::set<std::string>& from) {
+            std::set<std::string> out {from};
+            for (const auto& w : from)
+                for (std::size_t i = 0; i <= w.size(); ++i)
+                {
+                    if (i < w.size())
+                        out.insert(w.substr(0, i) + w.substr(i + 1));
+                    for (char c : std::string("abcdef"))
+                    {
+                        out.insert(w.substr(0, i) + c + w.substr(i));
+                        if (i < w.size())
+                            out.insert(w.substr(0, i) + c + w.substr(i + 1));
+                    }
+                }
+            return out;
+        };
+        auto anyAccepted = [&](const std::set<std::string>& words) {
+            for (const auto& w : words)
+                if (fa.stringBelongsToLanguage(w))
+                    return true;
+            return false;
+        };
+        ApproximateMatcher within2 {fa.approximateMatcher(2)};
+        std::vector<std::string> inputs {""};
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+            if (inputs[i].size() < 3)
+                for (char c : std::string("abcdefg"))
+                    inputs.push_back(inputs[i] + c);
+        for (const auto& input : inputs)
+        {
+            const std::set<std::string> one {ball({input})};
+            std::size_t expected {ApproximateMatcher::NPOS};
+            if (fa.stringBelongsToLanguage(input))
+                expected = 0;
+            else if (anyAccepted(one))
+                expected = 1;
+            else if (anyAccepted(ball(one)))
+                expected = 2;
+            assert(within2.distance(input) == expected);
+        }
+        assert(fa.editDistance("abcdea", 0) == 0 && fa.editDistance("abcde", 3) == 1);
+        assert(!fa.approximateMatcher(0).matches("abcde"));
+
+        // a 70-state chain takes the bitset path
+        std::string chain {"%initial Q0\n%final Q70\n"};
+        std::string word {};
+        for (int i = 0; i < 70; ++i)
+        {
+            word += static_cast<char>('a' + i % 3);
+            chain += "Q" + std::to_string(i) + " " + word.back() + " Q" + std::to_string(i + 1) + "\n";
+        }
+        const FiniteAutomaton line {FiniteAutomaton::fromText(chain)};
+        ApproximateMatcher within3 {line.approximateMatcher(3)};
+        std::string typo {word};
+        typo.erase(10, 1);               // deletion
+        typo.insert(30, "x");            // insertion
+        assert(within3.distance(word) == 0 && within3.distance(typo) == 2);
+        typo[50] = typo[50] == 'a' ? 'b' : 'a';
+        assert(within3.distance(typo) == 3);
+        typo[60] = typo[60] == 'a' ? 'b' : 'a';
+        assert(within3.distance(typo) == ApproximateMatcher::NPOS);
+        assert(within3.distance(word.substr(0, 67)) == 3 && !within3.matches(word.substr(0, 66)));
+    }
+
+    // ===== SYMBOL INTERNING =====
+    assert(fa.symbols().find("S") != SymbolTable::NPOS);
+    assert(fa.stateName(fa.initialIndex()) == "S");
+    assert(fa.stateCount() == 4 && fa.transitionCount() == 9);
+    {
+        // toGrammar shares the automaton's table; the round trip keeps the language
+        FiniteAutomaton back = fa.toGrammar().toFiniteAutomaton();
+        assert(back.symbolTable() == fa.symbolTable());
+        assert(back.stringBelongsToLanguage("abcdea") && !back.stringBelongsToLanguage("abcde"));
+        // conversions that invent names copy the table instead of mutating it
+        FiniteAutomaton dfa = fa.toDFA();
+        assert(dfa.symbolTable() != fa.symbolTable() && fa.symbols().find("Q0") == SymbolTable::NPOS);
+    }
+
+    // ===== COMPILED DFA =====
+    FiniteAutomaton dfa = fa.toDFA();
+    assert(dfa.compiledDFA() != nullptr);
+    assert(fa.compiledDFA() == nullptr || fa.isDeterministic());
+    assert(dfa.stringBelongsToLanguage("abcdea"));
+    assert(dfa.stringBelongsToLanguage("bffffa"));
+    assert(!dfa.stringBelongsToLanguage(""));
+    assert(!dfa.stringBelongsToLanguage("abcd"));
+    assert(!dfa.stringBelongsToLanguage("befx"));
+    assert(!dfa.stringBelongsToLanguage(std::string_view("ae\0", 3)));
+    // a..f each lead somewhere different, every other byte is dead: 7 classes
+    assert(dfa.stats().classes == 7);
+    assert(dfa.compiledDFA()->classOf('x') == dfa.compiledDFA()->classOf('\0'));
+    assert(dfa.stats().tableBytes < dfa.compiledDFA()->stateCount() * 256 * sizeof(CompiledDFA::StateId));
+
+    // P loops on b/c and Q on e/f: long runs are skipped, not stepped
+    assert(dfa.compiledDFA()->acceleratedCount() == 2);
+    {
+        std::string run {"a"};
+        for (int i = 0; i < 100; ++i)
+            run += "bbcbc"[i % 5];
+        assert(dfa.stringBelongsToLanguage(run + "e") && !dfa.stringBelongsToLanguage(run));
+        assert(!dfa.stringBelongsToLanguage(run + "xe") && dfa.stringBelongsToLanguage(run + "deffa"));
+        run[37] = 'x';
+        assert(!dfa.stringBelongsToLanguage(run + "e"));
+
+        // "anything up to ; or ,": one escape byte goes through memchr, two through SSE2
+        for (const char* escapes : {";", ";,"})
+        {
+            std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> loop {};
+            std::set<Symbol> bytes {};
+            for (int c = 0; c < 256; ++c)
+            {
+                const Symbol b(1, static_cast<char>(c));
+                bytes.insert(b);
+                loop[{"S", b}] = {std::strchr(escapes, c) && c != 0 ? "E" : "S"};
+            }
+            FiniteAutomaton until({"S", "E"}, bytes, loop, "S", {"E"});
+            assert(until.compiledDFA() && until.compiledDFA()->acceleratedCount() == 1);
+            std::string text(70, 'q');
+            text[3] = '\0';
+            assert(!until.stringBelongsToLanguage(text) && until.stringBelongsToLanguage(text + escapes[0]));
+            text[50] = escapes[std::strlen(escapes) - 1];
+            assert(!until.stringBelongsToLanguage(text));
+            assert(until.stringBelongsToLanguage(text.substr(0, 51)));
+            MatcherState m = until.matcher();
+            m.feed(text.substr(0, 20));
+            assert(!m.isAccepting() && !m.isDead());
+            m.feed(text.substr(20, 31));
+            assert(m.isAccepting());
+        }
+    }
+
+    // ===== STATE REORDERING =====
+    {
+        const std::vector<std::string_view> corpus {"bffffa", "bfea", "befa", "abbbe"};
+        FiniteAutomaton hot = dfa.reorderStates(corpus);
+        FiniteAutomaton depthFirst = dfa.reorderStates();
+        // Q (the f/e loop) is the hottest state, so it gets the first row
+        const std::vector<std::uint64_t> visits {hot.compiledDFA()->profile(corpus)};
+        assert(*std::max_element(visits.begin(), visits.end()) == visits[1]);
+        assert(hot.stats().tableBytes == dfa.stats().tableBytes && hot.states() == dfa.states());
+        for (const char* w : {"abcdea", "bffffa", "ae", "", "abcd", "befx", "abbdffeea", "aa", "bea"})
+            assert(hot.stringBelongsToLanguage(w) == dfa.stringBelongsToLanguage(w) &&
+                   depthFirst.stringBelongsToLanguage(w) == dfa.stringBelongsToLanguage(w));
+    }
+
+    // ===== PACKED TABLES =====
+    {
+        // "contains abca, bcab or cacb": deep rows mostly repeat the start row
+        FiniteAutomaton keywords = FiniteAutomaton::fromText(
+            "%initial S\n%final F\nS a S\nS b S\nS c S\nS d S\n"
+            "S a A1\nA1 b A2\nA2 c A3\nA3 a F\n"
+            "S b B1\nB1 c B2\nB2 a B3\nB3 b F\n"
+            "S c C1\nC1 a C2\nC2 c C3\nC3 b F\n"
+            "F a F\nF b F\nF c F\nF d F\n").toDFA(true);
+        FiniteAutomaton packed = keywords.withTableBudget(0);
+        assert(packed.compiledDFA() == nullptr && packed.packedDFA() != nullptr && packed.stats().packed);
+        assert(packed.packedDFA()->fallbackRows() > 0);
+        assert(packed.stats().tableBytes < keywords.stats().tableBytes);
+        assert(keywords.withTableBudget(1 << 20).compiledDFA() != nullptr);
+        std::mt19937 mt {5};
+        for (int i = 0; i < 2000; ++i)
+        {
+            std::string w(mt() % 12, 'a');
+            for (char& c : w)
+                c = "abcde"[mt() % 5];
+            assert(packed.stringBelongsToLanguage(w) == keywords.stringBelongsToLanguage(w));
+        }
+        MatcherState m = packed.matcher();
+        m.feed("ddab");
+        assert(!m.isAccepting() && !m.isDead());
+        m.feed("cadd");
+        assert(m.isAccepting());
+        m.feed("e");
+        assert(m.isDead());
+
+        FiniteAutomaton variantPacked = dfa.withTableBudget(0);
+        for (const char* w : {"abcdea", "bffffa", "ae", "", "abcd", "befx", "abbdffeea", "aa"})
+            assert(variantPacked.stringBelongsToLanguage(w) == dfa.stringBelongsToLanguage(w));
+    }
+
+    // ===== COMPILE-TIME DFA =====
+    {
+        static constexpr const char* VARIANT[] = {
+            "S->aP", "S->bQ", "P->bP", "P->cP", "P->dQ", "P->e", "Q->eQ", "Q->fQ", "Q->a"
+        };
+        static constexpr auto variant = StaticDFA<>::fromGrammar(VARIANT, 'S');
+        static_assert(variant.matches("abcdea") && variant.matches("bffffa") && variant.matches("ae"));
+        static_assert(!variant.matches("") && !variant.matches("abcd") && !variant.matches("befx"));
+        static_assert(variant.stateCount() == 5 && variant.classCount() == 7);
+        for (const char* w : {"abbdffeea", "adfea", "ba", "abz", "aa"})
+            assert(variant.matches(w) == fa.stringBelongsToLanguage(w));
+
+        // (a|b)*abb with an epsilon edge, as a transition list
+        static constexpr StaticEdge ABB[] = {
+            {'0', '\0', '1'}, {'1', 'a', '1'}, {'1', 'b', '1'}, {'1', 'a', '2'}, {'2', 'b', '3'}, {'3', 'b', '4'}
+        };
+        static constexpr auto abb = StaticDFA<8, 4>::fromTransitions(ABB, '0', "4");
+        static_assert(abb.matches("abb") && abb.matches("babaabb") && !abb.matches("abba") && !abb.matches(""));
+    }
+
+    // ===== GENERATED MATCHERS =====
+    // variantMatches and identifierMatches are emitted by lfagen at build time
+    for (const char* w : {"abcdea", "bffffa", "ae", "", "abcd", "befx", "abbdffeea", "aa"})
+        assert(variantMatches(w) == fa.stringBelongsToLanguage(w));
+    assert(identifierMatches("_tmp42") && identifierMatches("x") && identifierMatches("camelCase"));
+    assert(!identifierMatches("") && !identifierMatches("4ever") && !identifierMatches("a-b"));
+
+    // ===== TEMPLATED DFA =====
+    {
+        // small automata get one-byte state ids
+        AutoDFA<char> narrow {fa};
+        assert(narrow.stateBytes() == 1 && narrow.classCount() == 7);
+        BasicDFA<std::uint16_t, char> wide {fa};
+        for (const char* w : {"abcdea", "bffffa", "ae", "", "abcd", "befx", "abbdffeea", "aa"})
+            assert(narrow.matches(std::string_view{w}) == fa.stringBelongsToLanguage(w) &&
+                   wide.matches(std::string_view{w}) == fa.stringBelongsToLanguage(w));
+
+        // the same table run over Lab3 lexer tokens: IDENTIFIER ASSIGN operand (op operand)* SEMICOLON
+        FiniteAutomaton statement = FiniteAutomaton::fromText(
+            "%initial S\n%final E\n"
+            "S IDENTIFIER A\nA ASSIGN V\nV IDENTIFIER O\nV INT O\nV FLOAT O\n"
+            "O PLUS V\nO MINUS V\nO MULTIPLY V\nO SEMICOLON E\n");
+        auto tokenOf = [](const Symbol& name) -> std::optional<TokenType> {
+            for (int t = 0; t >= static_cast<int>(TokenType::VOID_TYPE); --t)
+                if (tokenTypeToString(static_cast<TokenType>(t)) == name)
+                    return static_cast<TokenType>(t);
+            return std::nullopt;
+        };
+        AutoDFA<TokenType> tokens {statement, tokenOf};
+        using T = TokenType;
+        assert(tokens.stateBytes() == 1);
+        assert(tokens.matches(std::vector<T>{T::IDENTIFIER, T::ASSIGN, T::INT, T::PLUS, T::IDENTIFIER, T::SEMICOLON}));
+        assert(!tokens.matches(std::vector<T>{T::IDENTIFIER, T::ASSIGN, T::PLUS, T::SEMICOLON}));
+        assert(!tokens.matches(std::vector<T>{T::IDENTIFIER, T::ASSIGN, T::INT, T::RETURN, T::SEMICOLON}));
+
+        // sparse 32-bit ids: keys 0 and 2^31 take a sorted key array, not a 2^31-slot map
+        FiniteAutomaton ids = FiniteAutomaton::fromText("%initial S\n%final E\nS 0 A\nA 2147483648 A\nA 7 E\n");
+        auto idOf = [](const Symbol& name) -> std::optional<std::uint32_t> {
+            return static_cast<std::uint32_t>(std::stoul(name));
+        };
+        BasicDFA<std::uint8_t, std::uint32_t> sparse {ids, idOf};
+        assert(sparse.isSparse() && sparse.tableBytes() < 1024);
+        assert(sparse.matches(std::vector<std::uint32_t>{0, 2147483648U, 2147483648U, 7}));
+        assert(!sparse.matches(std::vector<std::uint32_t>{0, 2147483647U, 7}) &&
+               !sparse.matches(std::vector<std::uint32_t>{0, 8}));
+        assert(!wide.isSparse());
+    }
+
+    // ===== SERIALIZATION =====
+    {
+        const std::string path {(std::filesystem::temp_directory_path() / "lfa_variant.dfa").string()};
+        dfa.compiledDFA()->save(path);
+        CompiledDFA loaded = CompiledDFA::load(path);
+        assert(loaded.stateCount() == dfa.compiledDFA()->stateCount() && loaded.classCount() == 7);
+        // acceleration records come from the file, not from re-analyzing the table
+        assert(loaded.acceleratedCount() == dfa.compiledDFA()->acceleratedCount() && loaded.acceleratedCount() > 0);
+        for (const char* w : {"abcdea", "bffffa", "ae", "", "abcd", "befx"})
+            assert(loaded.matches(w) == dfa.stringBelongsToLanguage(w));
+
+        // point an entry at another row: the checksum catches it
+        auto corruptAt = [&](std::streamoff offset, char value) {
+            std::fstream file {path, std::ios::in | std::ios::out | std::ios::binary};
+            file.seekp(offset);
+            file.put(value);
+        };
+        auto corruptEntry = [&](char value) { corruptAt(64 + 256 + 4, value); };
+        auto loadError = [&]() -> std::string {
+            try { CompiledDFA::load(path); }
+            catch (const std::runtime_error& e) { return e.what(); }
+            return "";
+        };
+        corruptEntry(static_cast<char>(loaded.rowOf(1)));
+        assert(loadError().find("checksum") != std::string::npos);
+        // past the table or between rows: rejected before the checksum is even compared
+        corruptEntry('\x7f');
+        assert(loadError().find("not a row offset") != std::string::npos);
+        corruptEntry(static_cast<char>(loaded.rowOf(1) + 1));
+        assert(loadError().find("not a row offset") != std::string::npos);
+        // a byte class past classCount would index past the row, even if it fits the row width
+        dfa.compiledDFA()->save(path);
+        corruptAt(64 + 'a', 7);
+        assert(loadError().find("byte class") != std::string::npos);
+        corruptAt(64 + 'a', '\x7f');
+        assert(loadError().find("byte class") != std::string::npos);
+        std::filesystem::remove(path);
+
+        std::ostringstream text {};
+        fa.saveText(text);
+        FiniteAutomaton parsed = FiniteAutomaton::fromText(text.str());
+        assert(parsed.states() == fa.states() && parsed.transitions() == fa.transitions());
+        assert(parsed.initialState() == "S" && parsed.finalStates() == fa.finalStates());
+        FiniteAutomaton eps = FiniteAutomaton::fromText("%initial A  # comment\n%final C\nA ε B\nB x C\n");
+        assert(eps.stringBelongsToLanguage("x") && eps.alphabet() == std::set<Symbol>{"x"});
+        bool badLine = false;
+        try { FiniteAutomaton::fromText("%initial A\nA b\n"); }
+        catch (const std::invalid_argument&) { badLine = true; }
+        assert(badLine);
+    }
+
+    // ===== STREAMING =====
+    {
+        MatcherState m = fa.matcher();
+        for (std::string_view chunk : {"a", "bbbbb", "", "cc", "de", "ff", "a"})
+            m.feed(chunk);
+        assert(m.isAccepting() && !m.isDead() && m.bytesConsumed() == 13);
+        m.feed("a");
+        assert(!m.isAccepting() && m.isDead());
+        m.reset();
+        m.feed("ae");
+        assert(m.isAccepting());
+        m.reset();
+        m.feed("z");
+        assert(m.isDead());
+    }
+
+    // ===== UNANCHORED SEARCH =====
+    {
+        Searcher search = fa.searcher();
+        auto spans = search.findAll("xxaexxabcdeaxxbazzbffffa");
+        assert((spans == std::vector<Span>{{2, 4}, {6, 12}, {14, 16}, {18, 24}}));
+        assert(search.findAll("").empty() && search.findAll("zzz").empty());
+
+        // a*b | a | bcd: compare with a brute-force leftmost-longest scan
+        FiniteAutomaton pat{{"S", "A", "X", "B", "C"}, {"a", "b", "c", "d"},
+                            {{{"S", "a"}, {"A", "X"}}, {{"A", "a"}, {"A"}}, {{"A", "b"}, {"X"}}, {{"S", "b"}, {"X", "B"}},
+                             {{"B", "c"}, {"C"}}, {{"C", "d"}, {"X"}}},
+                            "S", {"X"}};
+        Searcher patSearch = pat.searcher();
+        assert(patSearch.findAll("aaaa").size() == 4);
+        std::mt19937 gen{7};
+        for (int round = 0; round < 300; ++round)
+        {
+            std::string text(gen() % 24, 'a');
+            for (auto& ch : text)
+                ch = "abcdx"[gen() % 5];
+            std::vector<Span> expected;
+            for (size_t i = 0; i < text.size();)
+            {
+                size_t best = i;
+                for (size_t j = i + 1; j <= text.size(); ++j)
+                    if (pat.stringBelongsToLanguage(std::string_view(text).substr(i, j - i)))
+                        best = j;
+                if (best > i)
+                    expected.push_back({i, best});
+                i = best > i ? best : i + 1;
+            }
+            assert(patSearch.findAll(text) == expected);
+        }
+
+        // matches crossing the 64 KiB windows of reverse states
+        std::string text(200000, 'x');
+        std::fill(text.begin() + 65530, text.begin() + 131080, 'a');
+        text[131080] = 'b';
+        std::fill(text.begin() + 190000, text.end(), 'a');
+        auto longSpans = patSearch.findAll(text);
+        assert(longSpans.size() == 10001 && longSpans[0] == (Span{65530, 131081}));
+        assert(longSpans[1] == (Span{190000, 190001}) && longSpans.back() == (Span{199999, 200000}));
+    }
+
+    // ===== BATCH MATCHING =====
+    {
+        std::vector<std::string> words{"ae", "abcdea", "ba", "zzzz", "", "abcd", "bffffa", "befx"};
+        for (int i = 0; i < 10000; ++i)
+            words.push_back(words[i % 8] + (i % 3 ? "" : "a"));
+        std::vector<std::string_view> views(words.begin(), words.end());
+        std::vector<std::uint8_t> out;
+        fa.matchBatch(views, out, {4, 4});
+        assert(out.size() == views.size());
+        for (size_t i = 0; i < views.size(); ++i)
+            assert(static_cast<bool>(out[i]) == fa.stringBelongsToLanguage(views[i]));
+    }
+
+    // ===== MINIMIZATION =====
+    FiniteAutomaton minimal = fa.toDFA(true);
+    assert(minimal.states().size() == 4); // S, P, Q and the accepting state
+    assert(minimal.stringBelongsToLanguage("abcdea"));
+    assert(minimal.stringBelongsToLanguage("ae"));
+    assert(!minimal.stringBelongsToLanguage("abcd"));
+    {
+        // 12-state counter accepting lengths divisible by 3, plus an unreachable state
+        std::set<Symbol> cstates{"U"};
+        std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> ct{{{"U", "a"}, {"C0"}}};
+        for (int i = 0; i < 12; ++i)
+        {
+            cstates.insert("C" + std::to_string(i));
+            ct[{"C" + std::to_string(i), "a"}].insert("C" + std::to_string((i + 1) % 12));
+        }
+        FiniteAutomaton counter{cstates, {"a"}, ct, "C0", {"C0", "C3", "C6", "C9"}};
+        FiniteAutomaton small = counter.minimize();
+        assert(small.states().size() == 3);
+        for (size_t len = 0; len < 30; ++len)
+            assert(small.stringBelongsToLanguage(std::string(len, 'a')) == (len % 3 == 0));
+        assert(FiniteAutomaton({"A"}, {"a"}, {{{"A", "a"}, {"A"}}}, "A", {}).minimize().finalStates().empty());
+    }
+
+    // ===== NFA REDUCTION =====
+    {
+        // b*ab twice over behind epsilon moves, plus a dead and an unreachable state;
+        // S itself only leads to the dead X once A and B start in its place
+        FiniteAutomaton twins = FiniteAutomaton::fromText(
+            "%initial S\n%final F G\n"
+            "S ε A\nS ε B\nA b A\nB b B\nA a C\nB a D\nC b F\nD b G\nS a X\nU a F\n");
+        ReductionReport report {};
+        FiniteAutomaton reduced = twins.reduce(&report);
+        assert(report.statesBefore == 9 && report.afterTrim == 6 && report.afterForward == 3);
+        assert(report.statesAfter == 3 && reduced.stateCount() == 3 && reduced.isDeterministic());
+        std::vector<std::string> words {""};
+        for (std::size_t i = 0; i < words.size() && words[i].size() < 6; ++i)
+            for (char c : {'a', 'b'})
+                words.push_back(words[i] + c);
+        for (const auto& w : words)
+        {
+            assert(reduced.stringBelongsToLanguage(w) == twins.stringBelongsToLanguage(w));
+            assert(twins.toDFA().stringBelongsToLanguage(w) == twins.stringBelongsToLanguage(w));
+        }
+
+        // B is strictly simulated by A, so S -a-> B is a little brother and goes
+        FiniteAutomaton brothers = FiniteAutomaton::fromText(
+            "%initial S\n%final F\nS a A\nS a B\nS b B\nA b F\nA c F\nB b F\n");
+        FiniteAutomaton pruned = brothers.reduce(&report);
+        assert(report.prunedTransitions == 1 && report.transitionsAfter == 5 && pruned.isDeterministic());
+        for (const char* w : {"ab", "ac", "bb", "bc", "a", "", "abb"})
+            assert(pruned.stringBelongsToLanguage(w) == brothers.stringBelongsToLanguage(w));
+
+        FiniteAutomaton empty = FiniteAutomaton::fromText("%initial S\n%final F\nS a X\nU a F\n").reduce();
+        assert(empty.stateCount() == 1 && empty.finalStates().empty());
+    }
+
+    // ===== LANGUAGE EQUIVALENCE =====
+    {
+        std::string counterexample {};
+        assert(fa.equivalentTo(minimal) && minimal.equivalentTo(fa.toDFA(), &counterexample));
+        assert(counterexample.empty());
+        // the variant without Q -> fQ, in its own symbol table
+        FiniteAutomaton noF = FiniteAutomaton::fromText(
+            "%initial S\n%final X\nS a P\nS b Q\nP b P\nP c P\nP d Q\nP e X\nQ e Q\nQ a X\n");
+        assert(!minimal.equivalentTo(noF.toDFA(true), &counterexample) && counterexample == "bfa");
+        counterexample.clear();
+        assert(!fa.equivalentTo(noF, &counterexample) && counterexample == "bfa");
+        assert(noF.includedIn(fa) && !fa.includedIn(noF, &counterexample) && counterexample == "bfa");
+
+        // (a|b)*abb as an epsilon-NFA against (a|b)*bb
+        FiniteAutomaton abb = FiniteAutomaton::fromText(
+            "%initial S\n%final F\nS ε L\nL a L\nL b L\nL a A\nA b B\nB b F\n");
+        FiniteAutomaton bb = FiniteAutomaton::fromText("%initial S\n%final F\nS a S\nS b S\nS b B\nB b F\n");
+        assert(abb.equivalentTo(abb.toDFA(true)) && abb.includedIn(bb));
+        assert(!bb.includedIn(abb, &counterexample) && counterexample == "bb");
+        assert(!abb.equivalentTo(bb, &counterexample) && counterexample == "bb");
+    }
+
+    // ===== DENSE NFA =====
+    {
+        // a chain over 1000 symbols, one each: rows hold 1000 entries, not 1000 * 1001
+        std::string text {"%initial Q0\n%final Q1000\n"};
+        for (int i = 0; i < 1000; ++i)
+            text += "Q" + std::to_string(i) + " s" + std::to_string(i) + " Q" + std::to_string(i + 1) + "\n";
+        const FiniteAutomaton wide {FiniteAutomaton::fromText(text)};
+        DenseNFA dense {wide};
+        assert(dense.symbolCount() == 1000 && dense.entrySymbol.size() == 1000 && dense.direct.empty());
+        assert(dense.offsets.size() == 1001 && dense.targets.size() == 1000);
+        const std::size_t s7 {static_cast<std::size_t>(std::find(dense.symbols.begin(), dense.symbols.end(), "s7")
+                                                       - dense.symbols.begin())};
+        auto indexOf = [&](const Symbol& name) {
+            std::size_t q {0};
+            while (wide.stateName(q) != name)
+                ++q;
+            return q;
+        };
+        const std::size_t q7 {indexOf("Q7")};
+        assert(dense.succEnd(s7, q7) - dense.succBegin(s7, q7) == 1 && *dense.succBegin(s7, q7) == indexOf("Q8"));
+        assert(dense.succBegin(s7, indexOf("Q8")) == dense.succEnd(s7, indexOf("Q8")));
+        // small alphabets also get the direct index
+        assert(!DenseNFA {fa}.direct.empty());
+    }
+
+    // ===== BIT-PARALLEL NFA =====
+    // (a|b)* a (a|b)^k with an epsilon hop into the chain: k = 2 fits one word, k = 80 does not
+    for (int k : {2, 80})
+    {
+        std::set<Symbol> nstates{"S", "E"};
+        std::map<std::pair<Symbol, Symbol>, std::set<Symbol>> nt{
+            {{"S", "a"}, {"S", "E"}}, {{"S", "b"}, {"S"}}, {{"E", ""}, {"C0"}}};
+        for (int i = 0; i < k; ++i)
+        {
+            Symbol from = "C" + std::to_string(i), to = "C" + std::to_string(i + 1);
+            nstates.insert(from);
+            nt[{from, "a"}].insert(to);
+            nt[{from, "b"}].insert(to);
+        }
+        Symbol last = "C" + std::to_string(k);
+        nstates.insert(last);
+        FiniteAutomaton nfa{nstates, {"a", "b"}, nt, "S", {last}};
+        assert(nfa.compiledNFA() != nullptr && nfa.compiledDFA() == nullptr);
+        std::string tail(k, 'b');
+        assert(nfa.stringBelongsToLanguage("bba" + tail));
+        assert(nfa.stringBelongsToLanguage("a" + tail));
+        assert(!nfa.stringBelongsToLanguage("ab" + tail));
+        assert(!nfa.stringBelongsToLanguage(tail));
+        assert(!nfa.stringBelongsToLanguage("ac" + tail));
+        // lazy DFA with a cache small enough to force flushes on the k = 80 automaton
+        LazyDFA lazy = nfa.lazyDFA(16 * 1024);
+        std::mt19937 gen{42};
+        for (int i = 0; i < 200; ++i)
+        {
+            std::string word(k + 1 + gen() % 8, 'a');
+            for (auto& ch : word)
+                ch = "ab"[gen() % 2];
+            assert(lazy.matches(word) == nfa.stringBelongsToLanguage(word));
+            // the budget counts allocated capacity, so it holds across flushes
+            assert(lazy.stats().bytes <= lazy.cacheBytes() || lazy.stats().states == 1);
+        }
+        assert(lazy.matches("a" + tail) && !lazy.matches("ac" + tail));
+        std::string accepted = "a" + tail, rejected = "ab" + tail;
+        std::vector<std::uint8_t> batch;
+        nfa.matchBatch({accepted, rejected, accepted}, batch, {2, 1});
+        assert(batch == (std::vector<std::uint8_t>{1, 0, 1}));
+        MatcherState stream = nfa.matcher();
+        stream.feed("ba");
+        for (char ch : tail)
+            stream.feed(std::string_view(&ch, 1));
+        assert(stream.isAccepting());
+        stream.feed("c");
+        assert(stream.isDead());
+        assert(lazy.stats().misses > 0 && lazy.stats().hits > 0);
+        assert((k > 2) == (lazy.stats().flushes > 0));
+        assert(lazy.stats().bytes <= lazy.cacheBytes() || lazy.stats().states == 1);
+
+        if (k == 2)
+            assert(nfa.toDFA().stringBelongsToLanguage("bba" + tail));
+        else
+        {
+            bool overBudget = false;
+            try { nfa.toDFA(false, 1000); }
+            catch (const StateBudgetExceeded&) { overBudget = true; }
+            assert(overBudget);
+        }
+    }
     
     //=======test classify grammar============
     // g.classifyGrammar();